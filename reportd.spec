@@ -11,6 +11,7 @@ Source0:        https://github.com/abrt/%{name}/archive/%{version}/%{name}-%{ver
 
 BuildRequires:  gcc
 BuildRequires:  pkgconfig(glib-2.0)
+BuildRequires:  pkgconfig(gmodule-2.0)
 BuildRequires:  pkgconfig(libreport) >= 2.13.0
 BuildRequires:  meson
 BuildRequires:  systemd
@@ -48,6 +49,8 @@ A D-Bus service that exports libreport functionality.
 %doc NEWS README
 %license COPYING
 %{_libexecdir}/%{name}
+%dir %{_libdir}/%{name}
+%{_libdir}/%{name}/plugins/
 %{_datadir}/dbus-1/services/org.freedesktop.%{name}.service
 %{_datadir}/dbus-1/system-services/org.freedesktop.%{name}.service
 %{_datadir}/dbus-1/system.d/org.freedesktop.%{name}.conf
@@ -0,0 +1,263 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+/* Native executors for events that only copy a file or two into the problem
+ * directory, where spawning a shell for the handler costs more than the
+ * work itself.
+ */
+
+#include "reportd-executor-registry.h"
+
+#include <errno.h>
+#include <pwd.h>
+#include <string.h>
+#include <unistd.h>
+
+/* As many lines of the X session log as the shell handler keeps */
+#define REPORTD_COLLECT_XSESSION_ERRORS_LINES 999
+
+/* The contents of a problem element, with the trailing newline stripped,
+ * NULL if the problem does not have it.
+ */
+static char *
+reportd_collect_load_element (ReportdEventRun *run,
+                              const char      *element)
+{
+    g_autofree char *path = NULL;
+    char *contents;
+
+    path = g_build_filename (reportd_event_run_get_problem_directory (run), element, NULL);
+
+    if (!g_file_get_contents (path, &contents, NULL, NULL))
+    {
+        return NULL;
+    }
+
+    return g_strchomp (contents);
+}
+
+static bool
+reportd_collect_save_element (ReportdEventRun *run,
+                              const char      *element,
+                              const char      *contents,
+                              gssize           length)
+{
+    g_autofree char *path = NULL;
+    g_autoptr (GError) error = NULL;
+
+    path = g_build_filename (reportd_event_run_get_problem_directory (run), element, NULL);
+
+    if (!g_file_set_contents (path, contents, length, &error))
+    {
+        reportd_event_run_log (run, "Failed to save element '%s': %s", element, error->message);
+
+        return false;
+    }
+
+    reportd_event_run_log (run, "Element '%s' saved", element);
+
+    return true;
+}
+
+/* Copies a file into the problem directory if it exists. */
+static int
+reportd_collect_copy_file (ReportdEventRun *run,
+                           const char      *path,
+                           const char      *element)
+{
+    g_autofree char *contents = NULL;
+    g_autoptr (GError) error = NULL;
+    gsize length;
+
+    if (!g_file_get_contents (path, &contents, &length, &error))
+    {
+        if (g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+        {
+            return 0;
+        }
+
+        reportd_event_run_log (run, "Failed to read “%s”: %s", path, error->message);
+
+        return 1;
+    }
+
+    return reportd_collect_save_element (run, element, contents, length)? 0 : 1;
+}
+
+/* The home directory of the user the problem belongs to, NULL unless that is
+ * the user the daemon runs as: a daemon serving the system bus must not copy
+ * its own files, or anyone else’s, into a problem directory the user can
+ * read.
+ */
+static char *
+reportd_collect_get_home_dir (ReportdEventRun *run)
+{
+    g_autofree char *uid_string = NULL;
+    g_autofree char *buffer = NULL;
+    guint64 uid;
+    long size;
+    struct passwd entry;
+    struct passwd *result = NULL;
+
+    uid_string = reportd_collect_load_element (run, "uid");
+    if (NULL == uid_string ||
+        !g_ascii_string_to_unsigned (uid_string, 10, 0, G_MAXUINT32, &uid, NULL) ||
+        (uid_t) uid != getuid ())
+    {
+        return NULL;
+    }
+
+    size = sysconf (_SC_GETPW_R_SIZE_MAX);
+    if (size <= 0)
+    {
+        size = 16384;
+    }
+
+    buffer = g_malloc (size);
+
+    if (0 != getpwuid_r ((uid_t) uid, &entry, buffer, size, &result) || NULL == result)
+    {
+        reportd_event_run_log (run, "Failed to look up user %s: %s",
+                               uid_string, g_strerror (NULL == result? ENOENT : errno));
+
+        return NULL;
+    }
+
+    return g_strdup (entry.pw_dir);
+}
+
+static bool
+reportd_collect_executable_is_vim (ReportdEventRun *run)
+{
+    g_autofree char *executable = NULL;
+
+    executable = reportd_collect_load_element (run, "executable");
+
+    return g_strcmp0 (executable, "/usr/bin/vim") == 0 ||
+           g_strcmp0 (executable, "/usr/bin/gvim") == 0;
+}
+
+static int
+reportd_collect_vimrc_user (ReportdEventRun *run)
+{
+    g_autofree char *home = NULL;
+    g_autofree char *path = NULL;
+
+    if (!reportd_collect_executable_is_vim (run))
+    {
+        return 0;
+    }
+
+    home = reportd_collect_get_home_dir (run);
+    if (NULL == home)
+    {
+        return 0;
+    }
+
+    path = g_build_filename (home, ".vimrc", NULL);
+
+    return reportd_collect_copy_file (run, path, "vimrc_user");
+}
+
+static int
+reportd_collect_vimrc_system (ReportdEventRun *run)
+{
+    if (!reportd_collect_executable_is_vim (run))
+    {
+        return 0;
+    }
+
+    return reportd_collect_copy_file (run, "/etc/vimrc", "vimrc_system");
+}
+
+/* Keeps the lines of the X session log mentioning the crashed program, for
+ * crashes of programs using Xlib.
+ */
+static int
+reportd_collect_xsession_errors (ReportdEventRun *run)
+{
+    g_autofree char *analyzer = NULL;
+    g_autofree char *dso_list = NULL;
+    g_autofree char *executable = NULL;
+    g_autofree char *executable_name = NULL;
+    g_autofree char *home = NULL;
+    g_autofree char *path = NULL;
+    g_autofree char *contents = NULL;
+    g_autofree char *kept = NULL;
+    g_auto (GStrv) lines = NULL;
+    g_autoptr (GPtrArray) matching = NULL;
+    unsigned int first;
+
+    analyzer = reportd_collect_load_element (run, "analyzer");
+    dso_list = reportd_collect_load_element (run, "dso_list");
+    executable = reportd_collect_load_element (run, "executable");
+
+    if (g_strcmp0 (analyzer, "CCpp") != 0 || NULL == dso_list || NULL == executable ||
+        NULL == strstr (dso_list, "/libX11"))
+    {
+        return 0;
+    }
+
+    home = reportd_collect_get_home_dir (run);
+    if (NULL == home)
+    {
+        return 0;
+    }
+
+    path = g_build_filename (home, ".xsession-errors", NULL);
+    if (!g_file_get_contents (path, &contents, NULL, NULL))
+    {
+        return 0;
+    }
+
+    if (g_cancellable_is_cancelled (reportd_event_run_get_cancellable (run)))
+    {
+        return 1;
+    }
+
+    executable_name = g_path_get_basename (executable);
+    lines = g_strsplit (contents, "\n", -1);
+    matching = g_ptr_array_new ();
+
+    for (char **line = lines; NULL != *line; line++)
+    {
+        if (NULL != strstr (*line, executable_name))
+        {
+            g_ptr_array_add (matching, *line);
+        }
+    }
+
+    if (0 == matching->len)
+    {
+        return 0;
+    }
+
+    first = matching->len > REPORTD_COLLECT_XSESSION_ERRORS_LINES?
+            matching->len - REPORTD_COLLECT_XSESSION_ERRORS_LINES : 0;
+
+    g_ptr_array_add (matching, "");
+    g_ptr_array_add (matching, NULL);
+
+    kept = g_strjoinv ("\n", (char **) matching->pdata + first);
+
+    return reportd_collect_save_element (run, "xsession_errors", kept, -1)? 0 : 1;
+}
+
+void
+reportd_plugin_register (ReportdExecutorRegistry *registry)
+{
+    reportd_executor_registry_add (registry, "collect_vimrc_user", reportd_collect_vimrc_user);
+    reportd_executor_registry_add (registry, "collect_vimrc_system", reportd_collect_vimrc_system);
+    reportd_executor_registry_add (registry, "collect_xsession_errors", reportd_collect_xsession_errors);
+}
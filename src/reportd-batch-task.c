@@ -0,0 +1,668 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#include "reportd.h"
+
+#include "reportd-dbus-generated.h"
+
+struct _ReportdBatchTask
+{
+    GDBusObjectSkeleton parent;
+
+    ReportdDaemon *daemon;
+    GDBusConnection *connection;
+    char *owner;
+    /* Unique bus names of clients watching the batch task besides its
+     * owner, each with a watch on its name
+     */
+    GHashTable *subscribers;
+
+    ReportdDbusBatchTask *batch_task_iface;
+    char **problem_paths;
+    ReportdTaskContext *context;
+    unsigned int max_parallel;
+
+    /* Index of the next problem to be processed */
+    unsigned int next;
+    GPtrArray *running;
+    bool canceled;
+
+    GDBusMethodInvocation *invocation;
+};
+
+G_DEFINE_TYPE (ReportdBatchTask, reportd_batch_task, G_TYPE_DBUS_OBJECT_SKELETON)
+
+enum
+{
+    PROP_0,
+    PROP_DAEMON,
+    PROP_CONNECTION,
+    PROP_OWNER,
+    PROP_PROBLEM_PATHS,
+    PROP_CONTEXT,
+    PROP_MAX_PARALLEL,
+    N_PROPERTIES,
+};
+
+enum
+{
+    STARTED,
+    FINISHED,
+    N_SIGNALS,
+};
+
+static GParamSpec *properties[N_PROPERTIES];
+static unsigned int signals[N_SIGNALS];
+
+typedef struct
+{
+    ReportdBatchTask *batch;
+    ReportdTask *task;
+    GDBusInterface *task_iface;
+    const char *problem_path;
+} ReportdBatchTaskItem;
+
+static void
+reportd_batch_task_on_item_progress (ReportdDbusTask *object,
+                                     const char      *line,
+                                     gpointer         user_data)
+{
+    ReportdBatchTaskItem *item;
+    ReportdBatchTask *self;
+
+    item = user_data;
+    self = item->batch;
+
+    if (!reportd_task_send_signal_to_watchers (G_DBUS_INTERFACE_SKELETON (self->batch_task_iface),
+                                               self->owner, self->subscribers, "Progress",
+                                               g_variant_new ("(os)", item->problem_path, line)))
+    {
+        reportd_dbus_batch_task_emit_progress (self->batch_task_iface, item->problem_path, line);
+    }
+}
+
+static void
+reportd_batch_task_on_item_prompt (ReportdDbusTask *object,
+                                   const char      *path,
+                                   const char      *message,
+                                   unsigned int     type,
+                                   gpointer         user_data)
+{
+    ReportdBatchTaskItem *item;
+    ReportdBatchTask *self;
+
+    item = user_data;
+    self = item->batch;
+
+    if (!reportd_task_send_signal_to_watchers (G_DBUS_INTERFACE_SKELETON (self->batch_task_iface),
+                                               self->owner, self->subscribers, "Prompt",
+                                               g_variant_new ("(ossu)", item->problem_path,
+                                                              path, message, type)))
+    {
+        reportd_dbus_batch_task_emit_prompt (self->batch_task_iface,
+                                             item->problem_path, path, message, type);
+    }
+}
+
+static ReportdBatchTaskItem *
+reportd_batch_task_item_new (ReportdBatchTask *batch,
+                             const char       *problem_path)
+{
+    ReportdBatchTaskItem *item;
+
+    item = g_new0 (ReportdBatchTaskItem, 1);
+
+    item->batch = g_object_ref (batch);
+    item->problem_path = problem_path;
+    /* Items are never exported, all communication with the client goes
+     * through the batch object.
+     */
+    item->task = reportd_task_new (batch->daemon, batch->connection, batch->owner,
+                                   REPORTD_DBUS_TASK_PATH, problem_path, batch->context);
+    /* Don’t let a big batch hold up problems reported one at a time. */
+    reportd_task_set_priority (item->task, REPORTD_SCHEDULER_PRIORITY_BULK);
+    item->task_iface = g_dbus_object_get_interface (G_DBUS_OBJECT (item->task),
+                                                    "org.freedesktop.reportd.Task");
+
+    g_signal_connect (item->task_iface, "progress",
+                      G_CALLBACK (reportd_batch_task_on_item_progress), item);
+    g_signal_connect (item->task_iface, "prompt",
+                      G_CALLBACK (reportd_batch_task_on_item_prompt), item);
+
+    return item;
+}
+
+static void
+reportd_batch_task_item_free (ReportdBatchTaskItem *item)
+{
+    g_signal_handlers_disconnect_by_data (item->task_iface, item);
+
+    g_clear_object (&item->task_iface);
+    g_clear_object (&item->task);
+    g_clear_object (&item->batch);
+
+    g_free (item);
+}
+
+static void
+reportd_batch_task_finish (ReportdBatchTask *self)
+{
+    unsigned int failed;
+    unsigned int total;
+
+    failed = reportd_dbus_batch_task_get_failed (self->batch_task_iface);
+    total = reportd_dbus_batch_task_get_total (self->batch_task_iface);
+
+    if (self->canceled)
+    {
+        g_message ("Batch task canceled after processing %u of %u problems",
+                   self->next, total);
+
+        reportd_dbus_batch_task_set_status (self->batch_task_iface,
+                                            REPORTD_TASK_STATE_CANCELED);
+
+        g_dbus_method_invocation_return_error (self->invocation,
+                                               G_IO_ERROR, G_IO_ERROR_CANCELLED,
+                                               "Batch task was canceled");
+    }
+    else if (0 != failed)
+    {
+        g_message ("Batch task finished, %u of %u problems failed", failed, total);
+
+        reportd_dbus_batch_task_set_status (self->batch_task_iface,
+                                            REPORTD_TASK_STATE_FAILED);
+
+        g_dbus_method_invocation_return_error (self->invocation,
+                                               G_IO_ERROR, G_IO_ERROR_FAILED,
+                                               "Processing %u of %u problems failed",
+                                               failed, total);
+    }
+    else
+    {
+        g_message ("Batch task finished successfully");
+
+        reportd_dbus_batch_task_set_status (self->batch_task_iface,
+                                            REPORTD_TASK_STATE_COMPLETED);
+
+        reportd_dbus_batch_task_complete_start (self->batch_task_iface,
+                                                self->invocation);
+    }
+
+    self->invocation = NULL;
+
+    g_signal_emit (self, signals[FINISHED], 0);
+}
+
+static void reportd_batch_task_start_next (ReportdBatchTask *self);
+
+static void
+reportd_batch_task_on_item_finished (GObject      *source_object,
+                                     GAsyncResult *res,
+                                     gpointer      user_data)
+{
+    ReportdBatchTaskItem *item;
+    ReportdBatchTask *self;
+    g_autoptr (GError) error = NULL;
+
+    item = user_data;
+    self = item->batch;
+
+    if (reportd_task_run_finish (item->task, res, &error))
+    {
+        unsigned int completed;
+
+        completed = reportd_dbus_batch_task_get_completed (self->batch_task_iface);
+
+        reportd_dbus_batch_task_set_completed (self->batch_task_iface, completed + 1);
+    }
+    else if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+        unsigned int failed;
+
+        g_message ("Processing problem “%s” failed: %s",
+                   item->problem_path, error->message);
+
+        failed = reportd_dbus_batch_task_get_failed (self->batch_task_iface);
+
+        reportd_dbus_batch_task_set_failed (self->batch_task_iface, failed + 1);
+    }
+
+    g_ptr_array_remove_fast (self->running, item);
+
+    reportd_batch_task_start_next (self);
+
+    if (0 == self->running->len)
+    {
+        reportd_batch_task_finish (self);
+    }
+
+    reportd_batch_task_item_free (item);
+}
+
+static void
+reportd_batch_task_start_next (ReportdBatchTask *self)
+{
+    while (!self->canceled &&
+           self->running->len < self->max_parallel &&
+           NULL != self->problem_paths[self->next])
+    {
+        ReportdBatchTaskItem *item;
+
+        item = reportd_batch_task_item_new (self, self->problem_paths[self->next]);
+
+        self->next++;
+
+        g_ptr_array_add (self->running, item);
+
+        reportd_task_run_async (item->task, reportd_batch_task_on_item_finished, item);
+    }
+}
+
+static gboolean
+reportd_batch_task_on_authorize_method (GDBusInterfaceSkeleton *interface,
+                                        GDBusMethodInvocation  *invocation,
+                                        gpointer                user_data)
+{
+    ReportdBatchTask *self;
+    const char *method_name;
+
+    self = REPORTD_BATCH_TASK (user_data);
+    method_name = g_dbus_method_invocation_get_method_name (invocation);
+
+    /* Anyone may watch a batch task, everything else is up to its owner. */
+    if (g_strcmp0 (method_name, "Subscribe") == 0 ||
+        g_strcmp0 (method_name, "Unsubscribe") == 0)
+    {
+        return true;
+    }
+
+    return reportd_task_authorize_caller (invocation, self->owner);
+}
+
+static bool
+reportd_batch_task_handle_start (ReportdDbusBatchTask  *object,
+                                 GDBusMethodInvocation *invocation,
+                                 gpointer               user_data)
+{
+    ReportdBatchTask *self;
+
+    self = REPORTD_BATCH_TASK (user_data);
+
+    if (NULL != self->invocation ||
+        reportd_dbus_batch_task_get_status (object) != REPORTD_TASK_STATE_READY)
+    {
+        g_dbus_method_invocation_return_error (invocation,
+                                               G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                                               "Batch task has already been started");
+
+        return true;
+    }
+
+    g_message ("Starting batch task for %u problems, processing up to %u at a time",
+               reportd_dbus_batch_task_get_total (object), self->max_parallel);
+
+    self->invocation = invocation;
+
+    reportd_dbus_batch_task_set_status (object, REPORTD_TASK_STATE_RUNNING);
+
+    g_signal_emit (self, signals[STARTED], 0);
+
+    reportd_batch_task_start_next (self);
+
+    if (0 == self->running->len)
+    {
+        reportd_batch_task_finish (self);
+    }
+
+    return true;
+}
+
+void
+reportd_batch_task_cancel (ReportdBatchTask *self)
+{
+    g_return_if_fail (REPORTD_IS_BATCH_TASK (self));
+
+    g_message ("Canceling batch task");
+
+    self->canceled = true;
+
+    for (unsigned int i = 0; i < self->running->len; i++)
+    {
+        ReportdBatchTaskItem *item;
+
+        item = g_ptr_array_index (self->running, i);
+
+        reportd_task_cancel (item->task);
+    }
+}
+
+static bool
+reportd_batch_task_handle_cancel (ReportdDbusBatchTask  *object,
+                                  GDBusMethodInvocation *invocation,
+                                  gpointer               user_data)
+{
+    ReportdBatchTask *self;
+
+    self = REPORTD_BATCH_TASK (user_data);
+
+    reportd_batch_task_cancel (self);
+
+    reportd_dbus_batch_task_complete_cancel (object, invocation);
+
+    return true;
+}
+
+static bool
+reportd_batch_task_handle_subscribe (ReportdDbusBatchTask  *object,
+                                     GDBusMethodInvocation *invocation,
+                                     gpointer               user_data)
+{
+    ReportdBatchTask *self;
+
+    self = REPORTD_BATCH_TASK (user_data);
+
+    reportd_task_subscribe_caller (self->subscribers, invocation);
+
+    reportd_dbus_batch_task_complete_subscribe (object, invocation);
+
+    return true;
+}
+
+static bool
+reportd_batch_task_handle_unsubscribe (ReportdDbusBatchTask  *object,
+                                       GDBusMethodInvocation *invocation,
+                                       gpointer               user_data)
+{
+    ReportdBatchTask *self;
+
+    self = REPORTD_BATCH_TASK (user_data);
+
+    g_hash_table_remove (self->subscribers, g_dbus_method_invocation_get_sender (invocation));
+
+    reportd_dbus_batch_task_complete_unsubscribe (object, invocation);
+
+    return true;
+}
+
+static void
+reportd_batch_task_init (ReportdBatchTask *self)
+{
+    self->batch_task_iface = reportd_dbus_batch_task_skeleton_new ();
+    self->running = g_ptr_array_new ();
+    self->subscribers = reportd_task_subscribers_new ();
+
+    g_signal_connect (self->batch_task_iface, "g-authorize-method",
+                      G_CALLBACK (reportd_batch_task_on_authorize_method), self);
+    g_signal_connect (self->batch_task_iface, "handle-start",
+                      G_CALLBACK (reportd_batch_task_handle_start), self);
+    g_signal_connect (self->batch_task_iface, "handle-cancel",
+                      G_CALLBACK (reportd_batch_task_handle_cancel), self);
+    g_signal_connect (self->batch_task_iface, "handle-subscribe",
+                      G_CALLBACK (reportd_batch_task_handle_subscribe), self);
+    g_signal_connect (self->batch_task_iface, "handle-unsubscribe",
+                      G_CALLBACK (reportd_batch_task_handle_unsubscribe), self);
+
+    g_dbus_object_skeleton_add_interface (G_DBUS_OBJECT_SKELETON (self),
+                                          G_DBUS_INTERFACE_SKELETON (self->batch_task_iface));
+}
+
+static void
+reportd_batch_task_set_property (GObject      *object,
+                                 unsigned int  property_id,
+                                 const GValue *value,
+                                 GParamSpec   *pspec)
+{
+    ReportdBatchTask *self;
+
+    self = REPORTD_BATCH_TASK (object);
+
+    switch (property_id)
+    {
+        case PROP_DAEMON:
+        {
+            ReportdDaemon *daemon;
+
+            daemon = g_value_get_object (value);
+
+            g_set_object (&self->daemon, daemon);
+        }
+        break;
+
+        case PROP_CONNECTION:
+        {
+            GDBusConnection *connection;
+
+            connection = g_value_get_object (value);
+
+            g_set_object (&self->connection, connection);
+        }
+        break;
+
+        case PROP_OWNER:
+        {
+            self->owner = g_value_dup_string (value);
+        }
+        break;
+
+        case PROP_PROBLEM_PATHS:
+        {
+            self->problem_paths = g_value_dup_boxed (value);
+        }
+        break;
+
+        case PROP_CONTEXT:
+        {
+            self->context = g_value_dup_boxed (value);
+        }
+        break;
+
+        case PROP_MAX_PARALLEL:
+        {
+            self->max_parallel = g_value_get_uint (value);
+        }
+        break;
+
+        default:
+        {
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        }
+    }
+}
+
+static void
+reportd_batch_task_get_property (GObject      *object,
+                                 unsigned int  property_id,
+                                 GValue       *value,
+                                 GParamSpec   *pspec)
+{
+    ReportdBatchTask *self;
+
+    self = REPORTD_BATCH_TASK (object);
+
+    switch (property_id)
+    {
+        case PROP_DAEMON:
+        {
+            g_value_set_object (value, self->daemon);
+        }
+        break;
+
+        case PROP_CONNECTION:
+        {
+            g_value_set_object (value, self->connection);
+        }
+        break;
+
+        case PROP_OWNER:
+        {
+            g_value_set_string (value, self->owner);
+        }
+        break;
+
+        case PROP_PROBLEM_PATHS:
+        {
+            g_value_set_boxed (value, self->problem_paths);
+        }
+        break;
+
+        case PROP_CONTEXT:
+        {
+            g_value_set_boxed (value, self->context);
+        }
+        break;
+
+        case PROP_MAX_PARALLEL:
+        {
+            g_value_set_uint (value, self->max_parallel);
+        }
+        break;
+
+        default:
+        {
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        }
+    }
+}
+
+static void
+reportd_batch_task_constructed (GObject *object)
+{
+    ReportdBatchTask *self;
+
+    self = REPORTD_BATCH_TASK (object);
+
+    G_OBJECT_CLASS (reportd_batch_task_parent_class)->constructed (object);
+
+    if (NULL == self->problem_paths)
+    {
+        self->problem_paths = g_new0 (char *, 1);
+    }
+
+    reportd_dbus_batch_task_set_status (self->batch_task_iface, REPORTD_TASK_STATE_READY);
+    reportd_dbus_batch_task_set_total (self->batch_task_iface,
+                                       g_strv_length (self->problem_paths));
+}
+
+static void
+reportd_batch_task_dispose (GObject *object)
+{
+    ReportdBatchTask *self;
+
+    self = REPORTD_BATCH_TASK (object);
+
+    g_clear_object (&self->batch_task_iface);
+    g_clear_object (&self->connection);
+    g_clear_object (&self->daemon);
+
+    G_OBJECT_CLASS (reportd_batch_task_parent_class)->dispose (object);
+}
+
+static void
+reportd_batch_task_finalize (GObject *object)
+{
+    ReportdBatchTask *self;
+
+    self = REPORTD_BATCH_TASK (object);
+
+    g_clear_pointer (&self->problem_paths, g_strfreev);
+    g_clear_pointer (&self->owner, g_free);
+    g_clear_pointer (&self->context, reportd_task_context_unref);
+    g_clear_pointer (&self->running, g_ptr_array_unref);
+    g_clear_pointer (&self->subscribers, g_hash_table_destroy);
+
+    G_OBJECT_CLASS (reportd_batch_task_parent_class)->finalize (object);
+}
+
+static void
+reportd_batch_task_class_init (ReportdBatchTaskClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    object_class->set_property = reportd_batch_task_set_property;
+    object_class->get_property = reportd_batch_task_get_property;
+    object_class->constructed = reportd_batch_task_constructed;
+    object_class->dispose = reportd_batch_task_dispose;
+    object_class->finalize = reportd_batch_task_finalize;
+
+    properties[PROP_DAEMON] = g_param_spec_object ("daemon", "Daemon",
+                                                   "The owning daemon instance",
+                                                   REPORTD_TYPE_DAEMON,
+                                                   (G_PARAM_READWRITE |
+                                                    G_PARAM_CONSTRUCT_ONLY |
+                                                    G_PARAM_STATIC_STRINGS));
+    properties[PROP_CONNECTION] = g_param_spec_object ("connection", "Connection",
+                                                       "The connection the task is exported on",
+                                                       G_TYPE_DBUS_CONNECTION,
+                                                       (G_PARAM_READWRITE |
+                                                        G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+    properties[PROP_OWNER] = g_param_spec_string ("owner", "Owner",
+                                                  "Unique bus name of the client that created the task",
+                                                  NULL,
+                                                  (G_PARAM_READWRITE |
+                                                   G_PARAM_CONSTRUCT_ONLY |
+                                                   G_PARAM_STATIC_STRINGS));
+    properties[PROP_PROBLEM_PATHS] = g_param_spec_boxed ("problem-paths",
+                                                         "Problem Paths",
+                                                         "Object paths to the problems on the message bus",
+                                                         G_TYPE_STRV,
+                                                         (G_PARAM_READWRITE |
+                                                          G_PARAM_CONSTRUCT_ONLY |
+                                                          G_PARAM_STATIC_STRINGS));
+    properties[PROP_CONTEXT] = g_param_spec_boxed ("context", "Context",
+                                                   "The execution context shared by all problems in the batch",
+                                                   REPORTD_TYPE_TASK_CONTEXT,
+                                                   (G_PARAM_READWRITE |
+                                                    G_PARAM_CONSTRUCT_ONLY |
+                                                    G_PARAM_STATIC_STRINGS));
+    properties[PROP_MAX_PARALLEL] = g_param_spec_uint ("max-parallel", "Maximum Parallel",
+                                                       "The maximum number of problems processed at the same time",
+                                                       1, G_MAXUINT, 1,
+                                                       (G_PARAM_READWRITE |
+                                                        G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_properties (object_class, N_PROPERTIES, properties);
+
+    signals[STARTED] = g_signal_new ("started",
+                                     G_TYPE_FROM_CLASS (klass),
+                                     G_SIGNAL_RUN_LAST,
+                                     0, NULL, NULL, NULL,
+                                     G_TYPE_NONE, 0);
+    signals[FINISHED] = g_signal_new ("finished",
+                                      G_TYPE_FROM_CLASS (klass),
+                                      G_SIGNAL_RUN_LAST,
+                                      0, NULL, NULL, NULL,
+                                      G_TYPE_NONE, 0);
+}
+
+ReportdBatchTask *
+reportd_batch_task_new (ReportdDaemon       *daemon,
+                        GDBusConnection     *connection,
+                        const char          *owner,
+                        const char          *object_path,
+                        const char * const  *problem_paths,
+                        ReportdTaskContext  *context,
+                        unsigned int         max_parallel)
+{
+    return g_object_new (REPORTD_TYPE_BATCH_TASK,
+                         "daemon", daemon,
+                         "connection", connection,
+                         "owner", owner,
+                         "g-object-path", object_path,
+                         "problem-paths", problem_paths,
+                         "context", context,
+                         "max-parallel", max_parallel,
+                         NULL);
+}
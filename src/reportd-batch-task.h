@@ -0,0 +1,39 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#pragma once
+
+#include "reportd-task-context.h"
+#include "reportd-types.h"
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define REPORTD_TYPE_BATCH_TASK reportd_batch_task_get_type ()
+
+G_DECLARE_FINAL_TYPE (ReportdBatchTask, reportd_batch_task, REPORTD, BATCH_TASK,
+                      GDBusObjectSkeleton)
+
+void              reportd_batch_task_cancel (ReportdBatchTask *batch_task);
+
+ReportdBatchTask *reportd_batch_task_new (ReportdDaemon       *daemon,
+                                          GDBusConnection     *connection,
+                                          const char          *owner,
+                                          const char          *object_path,
+                                          const char * const  *problem_paths,
+                                          ReportdTaskContext  *context,
+                                          unsigned int         max_parallel);
+
+G_END_DECLS
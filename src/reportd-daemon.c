@@ -19,26 +19,57 @@
 #include <gio/gunixfdlist.h>
 #include <dump_dir.h>
 #include <stdlib.h>
+#include <workflow.h>
 
 /* D-Bus can pass only the following number of FDs in a single message */
 #define DBUS_FD_LIMIT 16
 
+/* A message bus the service is exported on */
+typedef struct
+{
+    GDBusConnection *connection;
+    GDBusObjectManagerServer *object_manager;
+    ReportdService *service;
+    unsigned int bus_id;
+    /* Problems2 keys sessions on the unique name of the client, so clients
+     * on different buses are only kept apart by asking it through separate
+     * connections to the system bus. This is the one for the clients on
+     * this bus, along with what was authorized and reported through it.
+     */
+    GDBusConnection *problems_connection;
+    ReportdProblemsSession *problems_session;
+    ReportdReportIndex *report_index;
+} ReportdDaemonBus;
+
 struct _ReportdDaemon
 {
     GObject parent_instance;
 
-    GBusType bus_type;
+    bool serve_system_bus;
+    bool serve_session_bus;
+    unsigned int workers;
 
     GFile *cache_directory;
+    ReportdResultCache *result_cache;
+    /* Shared by the services on all buses */
+    GHashTable *workflows;
+    ReportdEventRegistry *event_registry;
+    GFileMonitor *event_registry_monitor;
+    ReportdExecutorRegistry *executor_registry;
+    /* Workflow name → ReportdWorkflowPlan, built on first use */
+    GHashTable *workflow_plans;
 
     GMainLoop *main_loop;
 
     GDBusConnection *system_bus_connection;
     GDBusConnection *session_bus_connection;
 
-    unsigned int bus_id;
-    GDBusObjectManagerServer *object_manager;
-    ReportdService *service;
+    ReportdScheduler *scheduler;
+    ReportdMetrics *metrics;
+
+    GPtrArray *buses;
+    /* Used for suffixing object paths, never reused during daemon lifetime */
+    int last_object_id;
     GError *error;
 };
 
@@ -47,16 +78,35 @@ G_DEFINE_TYPE (ReportdDaemon, reportd_daemon, G_TYPE_OBJECT)
 enum
 {
     PROP_0,
-    PROP_BUS_TYPE,
+    PROP_SERVE_SYSTEM_BUS,
+    PROP_SERVE_SESSION_BUS,
+    PROP_WORKERS,
     N_PROPERTIES,
 };
 
 static GParamSpec *properties[N_PROPERTIES];
 
+static void
+reportd_daemon_bus_free (ReportdDaemonBus *bus)
+{
+    g_clear_handle_id (&bus->bus_id, g_bus_unown_name);
+    g_clear_object (&bus->service);
+    g_clear_object (&bus->object_manager);
+    g_clear_object (&bus->connection);
+    g_clear_object (&bus->problems_session);
+    g_clear_object (&bus->report_index);
+    g_clear_object (&bus->problems_connection);
+
+    g_free (bus);
+}
+
 static void
 reportd_daemon_init (ReportdDaemon *self)
 {
     self->main_loop = g_main_loop_new (NULL, FALSE);
+    self->buses = g_ptr_array_new_with_free_func ((GDestroyNotify) reportd_daemon_bus_free);
+    self->workflow_plans = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                  g_free, (GDestroyNotify) reportd_workflow_plan_unref);
 }
 
 static void
@@ -71,9 +121,21 @@ reportd_daemon_set_property (GObject      *object,
 
     switch (property_id)
     {
-        case PROP_BUS_TYPE:
+        case PROP_SERVE_SYSTEM_BUS:
+        {
+            self->serve_system_bus = g_value_get_boolean (value);
+        }
+        break;
+
+        case PROP_SERVE_SESSION_BUS:
+        {
+            self->serve_session_bus = g_value_get_boolean (value);
+        }
+        break;
+
+        case PROP_WORKERS:
         {
-            self->bus_type = g_value_get_enum (value);
+            self->workers = g_value_get_uint (value);
         }
         break;
 
@@ -96,9 +158,21 @@ reportd_daemon_get_property (GObject      *object,
 
     switch (property_id)
     {
-        case PROP_BUS_TYPE:
+        case PROP_SERVE_SYSTEM_BUS:
+        {
+            g_value_set_boolean (value, self->serve_system_bus);
+        }
+        break;
+
+        case PROP_SERVE_SESSION_BUS:
+        {
+            g_value_set_boolean (value, self->serve_session_bus);
+        }
+        break;
+
+        case PROP_WORKERS:
         {
-            g_value_set_enum (value, self->bus_type);
+            g_value_set_uint (value, self->workers);
         }
         break;
 
@@ -109,6 +183,19 @@ reportd_daemon_get_property (GObject      *object,
     }
 }
 
+static void
+reportd_daemon_constructed (GObject *object)
+{
+    ReportdDaemon *self;
+
+    self = REPORTD_DAEMON (object);
+
+    G_OBJECT_CLASS (reportd_daemon_parent_class)->constructed (object);
+
+    self->scheduler = reportd_scheduler_new (self->workers);
+    self->metrics = reportd_metrics_new ();
+}
+
 static void
 reportd_daemon_dispose (GObject *object)
 {
@@ -117,7 +204,13 @@ reportd_daemon_dispose (GObject *object)
     self = REPORTD_DAEMON (object);
 
     g_clear_object (&self->cache_directory);
-    g_clear_object (&self->object_manager);
+    g_clear_object (&self->result_cache);
+    g_clear_pointer (&self->buses, g_ptr_array_unref);
+    g_clear_object (&self->scheduler);
+    g_clear_object (&self->metrics);
+    g_clear_object (&self->event_registry_monitor);
+    g_clear_object (&self->event_registry);
+    g_clear_object (&self->executor_registry);
     g_clear_object (&self->system_bus_connection);
     g_clear_object (&self->session_bus_connection);
 }
@@ -130,7 +223,8 @@ reportd_daemon_finalize (GObject *object)
     self = REPORTD_DAEMON (object);
 
     g_clear_pointer (&self->main_loop, g_main_loop_unref);
-    g_clear_handle_id (&self->bus_id, g_bus_unown_name);
+    g_clear_pointer (&self->workflow_plans, g_hash_table_destroy);
+    g_clear_pointer (&self->workflows, g_hash_table_destroy);
 }
 
 static void
@@ -142,22 +236,58 @@ reportd_daemon_class_init (ReportdDaemonClass *klass)
 
     object_class->set_property = reportd_daemon_set_property;
     object_class->get_property = reportd_daemon_get_property;
+    object_class->constructed = reportd_daemon_constructed;
     object_class->dispose = reportd_daemon_dispose;
     object_class->finalize = reportd_daemon_finalize;
 
-    properties[PROP_BUS_TYPE] = g_param_spec_enum ("bus-type", "Bus Type",
-                                                   "The bus type to use for D-Bus connection",
-                                                   G_TYPE_BUS_TYPE,
-                                                   G_BUS_TYPE_SESSION,
-                                                   (G_PARAM_READWRITE |
-                                                    G_PARAM_CONSTRUCT_ONLY |
-                                                    G_PARAM_STATIC_STRINGS));
+    properties[PROP_SERVE_SYSTEM_BUS] = g_param_spec_boolean ("serve-system-bus",
+                                                              "Serve System Bus",
+                                                              "Whether to export the service on the system bus",
+                                                              false,
+                                                              (G_PARAM_READWRITE |
+                                                               G_PARAM_CONSTRUCT_ONLY |
+                                                               G_PARAM_STATIC_STRINGS));
+    properties[PROP_SERVE_SESSION_BUS] = g_param_spec_boolean ("serve-session-bus",
+                                                               "Serve Session Bus",
+                                                               "Whether to export the service on the session bus",
+                                                               true,
+                                                               (G_PARAM_READWRITE |
+                                                                G_PARAM_CONSTRUCT_ONLY |
+                                                                G_PARAM_STATIC_STRINGS));
+    properties[PROP_WORKERS] = g_param_spec_uint ("workers", "Workers",
+                                                  "Maximum number of tasks running at once",
+                                                  1, G_MAXINT, 1,
+                                                  (G_PARAM_READWRITE |
+                                                   G_PARAM_CONSTRUCT_ONLY |
+                                                   G_PARAM_STATIC_STRINGS));
 
     g_object_class_install_properties (object_class, N_PROPERTIES, properties);
 }
 
+/* The buses are all set up before the main loop is run, so this is safe to
+ * call from workers.
+ */
+static ReportdDaemonBus *
+reportd_daemon_get_bus (ReportdDaemon   *self,
+                        GDBusConnection *connection)
+{
+    for (unsigned int i = 0; i < self->buses->len; i++)
+    {
+        ReportdDaemonBus *bus;
+
+        bus = g_ptr_array_index (self->buses, i);
+
+        if (bus->connection == connection)
+        {
+            return bus;
+        }
+    }
+
+    return NULL;
+}
+
 static bool
-reportd_daemon_populate_dump_directory (ReportdDaemon    *self,
+reportd_daemon_populate_dump_directory (GDBusConnection  *problems_connection,
                                         const char       *entry,
                                         struct dump_dir  *dump_directory,
                                         const char      **elements,
@@ -181,7 +311,7 @@ reportd_daemon_populate_dump_directory (ReportdDaemon    *self,
         g_variant_builder_add_value (builder, strv);
         g_variant_builder_add_parsed (builder, "1");
 
-        tuple = g_dbus_connection_call_with_unix_fd_list_sync (self->system_bus_connection,
+        tuple = g_dbus_connection_call_with_unix_fd_list_sync (problems_connection,
                                                                "org.freedesktop.problems",
                                                                entry,
                                                                "org.freedesktop.Problems2.Entry",
@@ -224,11 +354,16 @@ reportd_daemon_populate_dump_directory (ReportdDaemon    *self,
     return true;
 }
 
+/* Copies of problems are shared by the clients on all buses, but only ever
+ * handed out after Problems2 has let the client’s bus see the entry.
+ */
 char *
-reportd_daemon_get_problem_directory (ReportdDaemon  *self,
-                                      const char     *entry,
-                                      GError        **error)
+reportd_daemon_get_problem_directory (ReportdDaemon    *self,
+                                      GDBusConnection  *connection,
+                                      const char       *entry,
+                                      GError          **error)
 {
+    ReportdDaemonBus *bus;
     g_autofree char *cache_directory_path = NULL;
     g_autofree char *canonical_entry = NULL;
     g_autofree char *base_name = NULL;
@@ -240,6 +375,10 @@ reportd_daemon_get_problem_directory (ReportdDaemon  *self,
     g_autofree const char **elements = NULL;
     struct dump_dir *dump_directory;
 
+    bus = reportd_daemon_get_bus (self, connection);
+
+    g_return_val_if_fail (NULL != bus, NULL);
+
     cache_directory_path = g_file_get_path (self->cache_directory);
     canonical_entry = g_canonicalize_filename (entry, "/");
     base_name = g_path_get_basename (canonical_entry);
@@ -247,16 +386,7 @@ reportd_daemon_get_problem_directory (ReportdDaemon  *self,
 
     g_return_val_if_fail (g_strcmp0 (cache_directory_path, cache_problem_directory_path) != 0, NULL);
 
-    if (g_file_test (cache_problem_directory_path, G_FILE_TEST_EXISTS | G_FILE_TEST_IS_DIR))
-    {
-        g_message ("Cache directory for entry “%s” already exists, returning", entry);
-
-        return g_steal_pointer (&cache_problem_directory_path);
-    }
-
-    g_message ("Pulling entry “%s”", entry);
-
-    tuple = g_dbus_connection_call_sync (self->system_bus_connection,
+    tuple = g_dbus_connection_call_sync (bus->problems_connection,
                                          "org.freedesktop.problems",
                                          entry,
                                          "org.freedesktop.DBus.Properties",
@@ -277,6 +407,15 @@ reportd_daemon_get_problem_directory (ReportdDaemon  *self,
     elements_variant = g_variant_get_variant (variant);
     elements = g_variant_get_strv (elements_variant, &element_count);
 
+    if (g_file_test (cache_problem_directory_path, G_FILE_TEST_EXISTS | G_FILE_TEST_IS_DIR))
+    {
+        g_message ("Cache directory for entry “%s” already exists, returning", entry);
+
+        return g_steal_pointer (&cache_problem_directory_path);
+    }
+
+    g_message ("Pulling entry “%s”", entry);
+
     if (g_mkdir_with_parents (cache_directory_path, 0700) == -1)
     {
         g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno), "%s",
@@ -287,7 +426,7 @@ reportd_daemon_get_problem_directory (ReportdDaemon  *self,
 
     dump_directory = dd_create_skeleton (cache_problem_directory_path, -1, 0600, 0);
 
-    if (!reportd_daemon_populate_dump_directory (self, entry, dump_directory,
+    if (!reportd_daemon_populate_dump_directory (bus->problems_connection, entry, dump_directory,
                                                  elements, element_count, error))
     {
         dd_close (dump_directory);
@@ -306,8 +445,8 @@ reportd_daemon_get_problem_directory (ReportdDaemon  *self,
  * But if SaveElements does not do what we want, then, well…
  */
 static void
-reportd_daemon_delete_volatile_elements (ReportdDaemon *self,
-                                         const char    *entry)
+reportd_daemon_delete_volatile_elements (GDBusConnection *problems_connection,
+                                         const char      *entry)
 {
     const char *elements[] =
     {
@@ -317,7 +456,7 @@ reportd_daemon_delete_volatile_elements (ReportdDaemon *self,
 
     g_autoptr (GVariant) variant = NULL;
 
-    variant = g_dbus_connection_call_sync (self->system_bus_connection,
+    variant = g_dbus_connection_call_sync (problems_connection,
                                            "org.freedesktop.problems",
                                            entry,
                                            "org.freedesktop.Problems2.Entry",
@@ -330,11 +469,11 @@ reportd_daemon_delete_volatile_elements (ReportdDaemon *self,
 }
 
 static bool
-reportd_daemon_save_elements (ReportdDaemon  *self,
-                              const char     *entry,
-                              GVariant       *dictionary,
-                              GUnixFDList    *fd_list,
-                              GError        **error)
+reportd_daemon_save_elements (GDBusConnection  *problems_connection,
+                              const char       *entry,
+                              GVariant         *dictionary,
+                              GUnixFDList      *fd_list,
+                              GError          **error)
 {
     g_autoptr (GVariantBuilder) builder = NULL;
     g_autoptr (GVariant) variant = NULL;
@@ -344,7 +483,7 @@ reportd_daemon_save_elements (ReportdDaemon  *self,
     g_variant_builder_add_value (builder, dictionary);
     g_variant_builder_add_parsed (builder, "0");
 
-    variant = g_dbus_connection_call_with_unix_fd_list_sync (self->system_bus_connection,
+    variant = g_dbus_connection_call_with_unix_fd_list_sync (problems_connection,
                                                              "org.freedesktop.problems",
                                                              entry,
                                                              "org.freedesktop.Problems2.Entry",
@@ -423,10 +562,12 @@ reportd_daemon_get_n_elements (struct dump_dir  *dump_directory,
 }
 
 bool
-reportd_daemon_push_problem_directory (ReportdDaemon  *self,
-                                       const char     *problem_directory,
-                                       GError        **error)
+reportd_daemon_push_problem_directory (ReportdDaemon    *self,
+                                       GDBusConnection  *connection,
+                                       const char       *problem_directory,
+                                       GError          **error)
 {
+    ReportdDaemonBus *bus;
     g_autoptr (GFile) file = NULL;
     g_autofree char *base_name = NULL;
     g_autofree char *entry = NULL;
@@ -435,6 +576,10 @@ reportd_daemon_push_problem_directory (ReportdDaemon  *self,
     g_autoptr (GUnixFDList) fd_list = NULL;
     g_autoptr (GError) tmp_error = NULL;
 
+    bus = reportd_daemon_get_bus (self, connection);
+
+    g_return_val_if_fail (NULL != bus, false);
+
     g_message ("Pushing problem directory “%s”", problem_directory);
 
     file = g_file_new_for_path (problem_directory);
@@ -465,7 +610,7 @@ reportd_daemon_push_problem_directory (ReportdDaemon  *self,
         return false;
     }
 
-    reportd_daemon_delete_volatile_elements (self, entry);
+    reportd_daemon_delete_volatile_elements (bus->problems_connection, entry);
 
     dd_init_next_file (dump_directory);
 
@@ -476,7 +621,7 @@ reportd_daemon_push_problem_directory (ReportdDaemon  *self,
 
         variant = g_variant_dict_end (dictionary);
 
-        if (!reportd_daemon_save_elements (self, entry, variant, fd_list, error))
+        if (!reportd_daemon_save_elements (bus->problems_connection, entry, variant, fd_list, error))
         {
             dd_close (dump_directory);
 
@@ -516,13 +661,181 @@ reportd_daemon_get_bus_connections (ReportdDaemon    *self,
     }
 }
 
+ReportdProblemsSession *
+reportd_daemon_get_problems_session (ReportdDaemon   *self,
+                                     GDBusConnection *connection)
+{
+    ReportdDaemonBus *bus;
+
+    g_return_val_if_fail (REPORTD_IS_DAEMON (self), NULL);
+
+    bus = reportd_daemon_get_bus (self, connection);
+
+    g_return_val_if_fail (NULL != bus, NULL);
+
+    return bus->problems_session;
+}
+
+ReportdEventRegistry *
+reportd_daemon_get_event_registry (ReportdDaemon *self)
+{
+    g_return_val_if_fail (REPORTD_IS_DAEMON (self), NULL);
+
+    return self->event_registry;
+}
+
+ReportdExecutorRegistry *
+reportd_daemon_get_executor_registry (ReportdDaemon *self)
+{
+    g_return_val_if_fail (REPORTD_IS_DAEMON (self), NULL);
+
+    return self->executor_registry;
+}
+
+ReportdMetrics *
+reportd_daemon_get_metrics (ReportdDaemon *self)
+{
+    g_return_val_if_fail (REPORTD_IS_DAEMON (self), NULL);
+
+    return self->metrics;
+}
+
+ReportdReportIndex *
+reportd_daemon_get_report_index (ReportdDaemon   *self,
+                                 GDBusConnection *connection)
+{
+    ReportdDaemonBus *bus;
+
+    g_return_val_if_fail (REPORTD_IS_DAEMON (self), NULL);
+
+    bus = reportd_daemon_get_bus (self, connection);
+
+    g_return_val_if_fail (NULL != bus, NULL);
+
+    return bus->report_index;
+}
+
+ReportdResultCache *
+reportd_daemon_get_result_cache (ReportdDaemon *self)
+{
+    g_return_val_if_fail (REPORTD_IS_DAEMON (self), NULL);
+
+    return self->result_cache;
+}
+
+ReportdScheduler *
+reportd_daemon_get_scheduler (ReportdDaemon *self)
+{
+    g_return_val_if_fail (REPORTD_IS_DAEMON (self), NULL);
+
+    return self->scheduler;
+}
+
+workflow_t *
+reportd_daemon_get_workflow (ReportdDaemon *self,
+                             const char    *name)
+{
+    g_return_val_if_fail (REPORTD_IS_DAEMON (self), NULL);
+
+    return g_hash_table_lookup (self->workflows, name);
+}
+
+/* Returns a new reference to the plan for running the workflow, or NULL if
+ * there is no such workflow.
+ */
+ReportdWorkflowPlan *
+reportd_daemon_get_workflow_plan (ReportdDaemon *self,
+                                  const char    *name)
+{
+    ReportdWorkflowPlan *plan;
+    workflow_t *workflow;
+
+    g_return_val_if_fail (REPORTD_IS_DAEMON (self), NULL);
+
+    plan = g_hash_table_lookup (self->workflow_plans, name);
+    if (NULL != plan)
+    {
+        return reportd_workflow_plan_ref (plan);
+    }
+
+    workflow = reportd_daemon_get_workflow (self, name);
+    if (NULL == workflow)
+    {
+        return NULL;
+    }
+
+    plan = reportd_workflow_plan_new (workflow, self->event_registry);
+
+    g_hash_table_insert (self->workflow_plans, g_strdup (name), plan);
+
+    return reportd_workflow_plan_ref (plan);
+}
+
+static void
+reportd_daemon_load_event_registry (ReportdDaemon *self)
+{
+    g_clear_object (&self->event_registry);
+
+    self->event_registry = reportd_event_registry_new (REPORTD_SYSCONFDIR "/events.conf");
+}
+
+/* Plans already handed out stay valid, tasks created from now on get ones
+ * built from the new configuration. Only events.conf is watched: libreport
+ * loads its workflow and event configuration once per process, so changes
+ * to those take a restart of the daemon, as they always have.
+ */
+static void
+reportd_daemon_on_event_registry_changed (GFileMonitor      *monitor,
+                                          GFile             *file,
+                                          GFile             *other_file,
+                                          GFileMonitorEvent  event_type,
+                                          gpointer           user_data)
+{
+    ReportdDaemon *self;
+
+    self = REPORTD_DAEMON (user_data);
+
+    if (G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT != event_type &&
+        G_FILE_MONITOR_EVENT_CREATED != event_type &&
+        G_FILE_MONITOR_EVENT_DELETED != event_type)
+    {
+        return;
+    }
+
+    g_message ("Event configuration changed, reloading");
+
+    reportd_daemon_load_event_registry (self);
+
+    g_hash_table_remove_all (self->workflow_plans);
+}
+
+/* Exports the object under its path suffixed with a fresh ID. Unlike
+ * g_dbus_object_manager_server_export_uniquely(), which probes for a free
+ * suffix, this does not get any slower with the number of objects exported
+ * in the past.
+ */
 void
 reportd_daemon_register_object (ReportdDaemon       *self,
+                                GDBusConnection     *connection,
                                 GDBusObjectSkeleton *object)
 {
+    ReportdDaemonBus *bus;
+    const char *object_path;
+    unsigned int object_id;
+    g_autofree char *unique_object_path = NULL;
+
     g_return_if_fail (REPORTD_IS_DAEMON (self));
 
-    g_dbus_object_manager_server_export_uniquely (self->object_manager, object);
+    bus = reportd_daemon_get_bus (self, connection);
+
+    g_return_if_fail (NULL != bus);
+
+    object_path = g_dbus_object_get_object_path (G_DBUS_OBJECT (object));
+    object_id = (unsigned int) g_atomic_int_add (&self->last_object_id, 1) + 1;
+    unique_object_path = g_strdup_printf ("%s/%u", object_path, object_id);
+
+    g_dbus_object_skeleton_set_object_path (object, unique_object_path);
+    g_dbus_object_manager_server_export (bus->object_manager, object);
 }
 
 void
@@ -533,9 +846,42 @@ reportd_daemon_unregister_object (ReportdDaemon *self,
 
     g_return_if_fail (REPORTD_IS_DAEMON (self));
 
+    if (NULL == self->buses)
+    {
+        return;
+    }
+
     object_path = g_dbus_object_get_object_path (object);
 
-    g_dbus_object_manager_server_unexport (self->object_manager, object_path);
+    for (unsigned int i = 0; i < self->buses->len; i++)
+    {
+        ReportdDaemonBus *bus;
+
+        bus = g_ptr_array_index (self->buses, i);
+
+        if (g_dbus_object_manager_server_is_exported (bus->object_manager,
+                                                      G_DBUS_OBJECT_SKELETON (object)))
+        {
+            g_dbus_object_manager_server_unexport (bus->object_manager, object_path);
+
+            return;
+        }
+    }
+}
+
+static void
+reportd_daemon_on_name_acquired (GDBusConnection *connection,
+                                 const char      *name,
+                                 gpointer         user_data)
+{
+    ReportdDaemon *daemon;
+    ReportdDaemonBus *bus;
+
+    daemon = REPORTD_DAEMON (user_data);
+    bus = reportd_daemon_get_bus (daemon, connection);
+
+    /* Get the session ready before any client needs it. */
+    reportd_problems_session_connect (bus->problems_session);
 }
 
 static void
@@ -554,12 +900,59 @@ reportd_daemon_on_name_lost (GDBusConnection *connection,
     reportd_daemon_quit (daemon, error);
 }
 
+static void
+reportd_daemon_serve_bus (ReportdDaemon   *self,
+                          GDBusConnection *connection,
+                          GDBusConnection *problems_connection)
+{
+    ReportdDaemonBus *bus;
+
+    bus = g_new0 (ReportdDaemonBus, 1);
+
+    bus->connection = g_object_ref (connection);
+    bus->problems_connection = g_object_ref (problems_connection);
+    bus->problems_session = reportd_problems_session_new (problems_connection);
+    bus->report_index = reportd_report_index_new ();
+    bus->object_manager = g_dbus_object_manager_server_new (REPORTD_DBUS_OBJECT_MANAGER_PATH);
+    bus->service = reportd_service_new (self, REPORTD_DBUS_SERVICE_PATH);
+
+    g_dbus_object_manager_server_export (bus->object_manager,
+                                         G_DBUS_OBJECT_SKELETON (bus->service));
+
+    g_dbus_object_manager_server_set_connection (bus->object_manager, connection);
+
+    g_ptr_array_add (self->buses, bus);
+
+    bus->bus_id = g_bus_own_name_on_connection (connection,
+                                                REPORTD_DBUS_BUS_NAME,
+                                                G_BUS_NAME_OWNER_FLAGS_DO_NOT_QUEUE,
+                                                reportd_daemon_on_name_acquired,
+                                                reportd_daemon_on_name_lost,
+                                                self, NULL);
+}
+
+/* A connection to the system bus of its own, with a unique name of its own */
+static GDBusConnection *
+reportd_daemon_new_system_bus_connection (GError **error)
+{
+    g_autofree char *address = NULL;
+
+    address = g_dbus_address_get_for_bus_sync (G_BUS_TYPE_SYSTEM, NULL, error);
+    if (NULL == address)
+    {
+        return NULL;
+    }
+
+    return g_dbus_connection_new_for_address_sync (address,
+                                                   (G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                                                    G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION),
+                                                   NULL, NULL, error);
+}
+
 static bool
 reportd_daemon_connect_to_bus (ReportdDaemon  *self,
                                GError        **error)
 {
-    GDBusConnection *connection;
-
     g_return_val_if_fail (REPORTD_IS_DAEMON (self), false);
 
     self->system_bus_connection = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, error);
@@ -567,33 +960,38 @@ reportd_daemon_connect_to_bus (ReportdDaemon  *self,
     {
         return false;
     }
-    if (self->bus_type == G_BUS_TYPE_SESSION)
+    if (self->serve_session_bus)
     {
+        g_autoptr (GDBusConnection) problems_connection = NULL;
+
         self->session_bus_connection = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, error);
         if (NULL == self->session_bus_connection)
         {
             return false;
         }
 
-        connection = self->session_bus_connection;
+        if (self->serve_system_bus)
+        {
+            problems_connection = reportd_daemon_new_system_bus_connection (error);
+            if (NULL == problems_connection)
+            {
+                return false;
+            }
+
+            g_message ("Serving both buses, each with a problems session "
+                       "and report index of its own");
+        }
+        else
+        {
+            problems_connection = g_object_ref (self->system_bus_connection);
+        }
+
+        reportd_daemon_serve_bus (self, self->session_bus_connection, problems_connection);
     }
-    else
+    if (self->serve_system_bus)
     {
-        connection = self->system_bus_connection;
+        reportd_daemon_serve_bus (self, self->system_bus_connection, self->system_bus_connection);
     }
-    self->object_manager = g_dbus_object_manager_server_new (REPORTD_DBUS_OBJECT_MANAGER_PATH);
-    self->service = reportd_service_new (self, REPORTD_DBUS_SERVICE_PATH);
-
-    reportd_daemon_register_object (self, G_DBUS_OBJECT_SKELETON (self->service));
-
-    g_dbus_object_manager_server_set_connection (self->object_manager, connection);
-
-    self->bus_id = g_bus_own_name_on_connection (connection,
-                                                 REPORTD_DBUS_BUS_NAME,
-                                                 G_BUS_NAME_OWNER_FLAGS_DO_NOT_QUEUE,
-                                                 NULL,
-                                                 reportd_daemon_on_name_lost,
-                                                 self, NULL);
 
     return true;
 }
@@ -603,15 +1001,32 @@ reportd_daemon_run (ReportdDaemon  *self,
                     GError        **error)
 {
     g_autoptr (GFile) file = NULL;
+    g_autofree char *results_path = NULL;
 
     g_return_val_if_fail (REPORTD_IS_DAEMON (self), EXIT_FAILURE);
 
-    if (!reportd_daemon_connect_to_bus (self, error))
+    self->workflows = libreport_load_workflow_config_data (NULL);
+
+    reportd_daemon_load_event_registry (self);
+
+    file = g_file_new_for_path (REPORTD_SYSCONFDIR "/events.conf");
+    self->event_registry_monitor = g_file_monitor_file (file, G_FILE_MONITOR_NONE, NULL, NULL);
+    if (NULL != self->event_registry_monitor)
     {
-        return EXIT_FAILURE;
+        g_signal_connect (self->event_registry_monitor, "changed",
+                          G_CALLBACK (reportd_daemon_on_event_registry_changed), self);
     }
 
+    self->executor_registry = reportd_executor_registry_new (REPORTD_PLUGINDIR);
+
     self->cache_directory = g_file_new_for_path ("/tmp/reportd");
+    results_path = g_build_filename (g_get_user_cache_dir (), "reportd", "results", NULL);
+    self->result_cache = reportd_result_cache_new (results_path);
+
+    if (!reportd_daemon_connect_to_bus (self, error))
+    {
+        return EXIT_FAILURE;
+    }
 
     g_main_loop_run (self->main_loop);
 
@@ -644,8 +1059,21 @@ reportd_daemon_quit (ReportdDaemon *self,
      * a reference on the service to be dropped, and then remove our internal
      * reference, which also drops the daemon reference count.
      */
-    reportd_daemon_unregister_object (self, G_DBUS_OBJECT (self->service));
-    g_clear_object (&self->service);
+    for (unsigned int i = 0; i < self->buses->len; i++)
+    {
+        ReportdDaemonBus *bus;
+
+        bus = g_ptr_array_index (self->buses, i);
+
+        if (NULL == bus->service)
+        {
+            continue;
+        }
+
+        g_dbus_object_manager_server_unexport (bus->object_manager,
+                                               REPORTD_DBUS_SERVICE_PATH);
+        g_clear_object (&bus->service);
+    }
 
     g_main_loop_quit (self->main_loop);
 
@@ -656,11 +1084,13 @@ reportd_daemon_quit (ReportdDaemon *self,
 }
 
 ReportdDaemon *
-reportd_daemon_new (bool use_system_bus)
+reportd_daemon_new (bool         serve_system_bus,
+                    bool         serve_session_bus,
+                    unsigned int workers)
 {
-    GBusType bus_type;
-
-    bus_type = use_system_bus? G_BUS_TYPE_SYSTEM : G_BUS_TYPE_SESSION;
-
-    return g_object_new (REPORTD_TYPE_DAEMON, "bus-type", bus_type, NULL);
+    return g_object_new (REPORTD_TYPE_DAEMON,
+                         "serve-system-bus", serve_system_bus,
+                         "serve-session-bus", serve_session_bus,
+                         "workers", workers,
+                         NULL);
 }
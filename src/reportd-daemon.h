@@ -14,18 +14,31 @@
 
 #pragma once
 
+#include "reportd-event-registry.h"
+#include "reportd-executor-registry.h"
+#include "reportd-metrics.h"
+#include "reportd-problems-session.h"
+#include "reportd-report-index.h"
+#include "reportd-result-cache.h"
+#include "reportd-scheduler.h"
+#include "reportd-workflow-plan.h"
+
 #include <stdbool.h>
 
 #include <gio/gio.h>
 
+#include <workflow.h>
+
 #define REPORTD_TYPE_DAEMON reportd_daemon_get_type ()
 
 G_DECLARE_FINAL_TYPE (ReportdDaemon, reportd_daemon, REPORTD, DAEMON, GObject)
 
 char          *reportd_daemon_get_problem_directory  (ReportdDaemon        *daemon,
+                                                      GDBusConnection      *connection,
                                                       const char           *entry,
                                                       GError              **error);
 bool           reportd_daemon_push_problem_directory (ReportdDaemon        *daemon,
+                                                      GDBusConnection      *connection,
                                                       const char           *problem_directory,
                                                       GError              **error);
 
@@ -33,7 +46,38 @@ void           reportd_daemon_get_bus_connections    (ReportdDaemon        *daem
                                                       GDBusConnection     **system_bus_connection,
                                                       GDBusConnection     **session_bus_connection);
 
+ReportdProblemsSession *
+               reportd_daemon_get_problems_session   (ReportdDaemon        *daemon,
+                                                      GDBusConnection      *connection);
+
+ReportdEventRegistry *
+               reportd_daemon_get_event_registry     (ReportdDaemon        *daemon);
+
+ReportdExecutorRegistry *
+               reportd_daemon_get_executor_registry (ReportdDaemon        *daemon);
+
+ReportdMetrics *
+               reportd_daemon_get_metrics            (ReportdDaemon        *daemon);
+
+ReportdReportIndex *
+               reportd_daemon_get_report_index       (ReportdDaemon        *daemon,
+                                                      GDBusConnection      *connection);
+
+ReportdResultCache *
+               reportd_daemon_get_result_cache       (ReportdDaemon        *daemon);
+
+ReportdScheduler *
+               reportd_daemon_get_scheduler          (ReportdDaemon        *daemon);
+
+struct workflow *
+               reportd_daemon_get_workflow           (ReportdDaemon        *daemon,
+                                                      const char           *name);
+ReportdWorkflowPlan *
+               reportd_daemon_get_workflow_plan      (ReportdDaemon        *daemon,
+                                                      const char           *name);
+
 void           reportd_daemon_register_object        (ReportdDaemon        *daemon,
+                                                      GDBusConnection      *connection,
                                                       GDBusObjectSkeleton  *object);
 void           reportd_daemon_unregister_object      (ReportdDaemon        *daemon,
                                                       GDBusObject          *object);
@@ -43,4 +87,6 @@ int            reportd_daemon_run                    (ReportdDaemon        *daem
 void           reportd_daemon_quit                   (ReportdDaemon        *daemon,
                                                       GError               *error);
 
-ReportdDaemon *reportd_daemon_new                    (bool                  use_system_bus);
+ReportdDaemon *reportd_daemon_new                    (bool                  serve_system_bus,
+                                                      bool                  serve_session_bus,
+                                                      unsigned int          workers);
@@ -0,0 +1,422 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#include "reportd-event-registry.h"
+
+#include <string.h>
+
+struct _ReportdEventRegistry
+{
+    GObject parent;
+
+    char *path;
+    /* Event name → ReportdEventInfo */
+    GHashTable *events;
+    /* Workflow name → timeout in seconds */
+    GHashTable *workflow_timeouts;
+    /* Names of the workflows that report duplicates only once */
+    GHashTable *deduplicated_workflows;
+};
+
+#define REPORTD_EVENT_REGISTRY_WORKFLOW_PREFIX "Workflow "
+
+G_DEFINE_TYPE (ReportdEventRegistry, reportd_event_registry, G_TYPE_OBJECT)
+
+enum
+{
+    PROP_0,
+    PROP_PATH,
+    N_PROPERTIES,
+};
+
+static GParamSpec *properties[N_PROPERTIES];
+
+static void
+reportd_event_info_free (ReportdEventInfo *info)
+{
+    g_strfreev (info->reads);
+    g_strfreev (info->writes);
+    g_strfreev (info->after);
+
+    g_free (info);
+}
+
+static bool
+reportd_event_info_has_footprint (const ReportdEventInfo *info)
+{
+    return NULL != info->reads || NULL != info->writes;
+}
+
+static bool
+reportd_strv_intersect (char * const *a,
+                        char * const *b)
+{
+    if (NULL == a || NULL == b)
+    {
+        return false;
+    }
+
+    for (; NULL != *a; a++)
+    {
+        if (g_strv_contains ((const char * const *) b, *a))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Whether an event described by @info has to wait for @event, which comes
+ * before it in the workflow. Events nothing is known about are ordered
+ * against everything else, as are events touching the same elements when
+ * at least one of them writes.
+ */
+bool
+reportd_event_info_depends_on (const ReportdEventInfo *info,
+                               const char             *event,
+                               const ReportdEventInfo *event_info)
+{
+    if (NULL == info || NULL == event_info)
+    {
+        return true;
+    }
+    if (NULL != info->after && g_strv_contains ((const char * const *) info->after, event))
+    {
+        return true;
+    }
+    if (!reportd_event_info_has_footprint (info) || !reportd_event_info_has_footprint (event_info))
+    {
+        /* Only the explicit ordering counts if either one leaves it at that. */
+        return NULL == info->after && NULL == event_info->after;
+    }
+
+    return reportd_strv_intersect (event_info->writes, info->reads) ||
+           reportd_strv_intersect (event_info->writes, info->writes) ||
+           reportd_strv_intersect (event_info->reads, info->writes);
+}
+
+const ReportdEventInfo *
+reportd_event_registry_lookup (ReportdEventRegistry *self,
+                               const char           *event)
+{
+    g_return_val_if_fail (REPORTD_IS_EVENT_REGISTRY (self), NULL);
+
+    return g_hash_table_lookup (self->events, event);
+}
+
+unsigned int
+reportd_event_registry_get_workflow_timeout (ReportdEventRegistry *self,
+                                             const char           *workflow)
+{
+    g_return_val_if_fail (REPORTD_IS_EVENT_REGISTRY (self), 0);
+
+    return GPOINTER_TO_UINT (g_hash_table_lookup (self->workflow_timeouts, workflow));
+}
+
+bool
+reportd_event_registry_get_workflow_deduplicate (ReportdEventRegistry *self,
+                                                 const char           *workflow)
+{
+    g_return_val_if_fail (REPORTD_IS_EVENT_REGISTRY (self), false);
+
+    return g_hash_table_contains (self->deduplicated_workflows, workflow);
+}
+
+static unsigned int
+reportd_event_registry_get_timeout (GKeyFile   *key_file,
+                                    const char *group)
+{
+    g_autoptr (GError) error = NULL;
+    int timeout;
+
+    timeout = g_key_file_get_integer (key_file, group, "Timeout", &error);
+    if (NULL != error)
+    {
+        if (!g_error_matches (error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_KEY_NOT_FOUND))
+        {
+            g_warning ("Ignoring timeout of “%s”: %s", group, error->message);
+        }
+
+        return 0;
+    }
+
+    return MAX (timeout, 0);
+}
+
+void
+reportd_event_priority_init_default (ReportdEventPriority *priority,
+                                     const char           *event)
+{
+    g_return_if_fail (NULL != priority);
+    g_return_if_fail (NULL != event);
+
+    if (g_str_has_prefix (event, "analyze_"))
+    {
+        priority->nice = 10;
+        priority->io_class = REPORTD_EVENT_IO_CLASS_BEST_EFFORT;
+        priority->scheduler = REPORTD_EVENT_SCHEDULER_BATCH;
+    }
+    else
+    {
+        priority->nice = 0;
+        priority->io_class = REPORTD_EVENT_IO_CLASS_DEFAULT;
+        priority->scheduler = REPORTD_EVENT_SCHEDULER_DEFAULT;
+    }
+}
+
+/* Nice, IOClass (“default”, “best-effort” or “idle”) and Scheduler
+ * (“default”, “batch” or “idle”), each falling back to the default for the
+ * event if missing or not understood.
+ */
+static void
+reportd_event_registry_get_priority (GKeyFile             *key_file,
+                                     const char           *group,
+                                     ReportdEventPriority *priority)
+{
+    g_autoptr (GError) error = NULL;
+    g_autofree char *io_class = NULL;
+    g_autofree char *scheduler = NULL;
+    int niceness;
+
+    reportd_event_priority_init_default (priority, group);
+
+    niceness = g_key_file_get_integer (key_file, group, "Nice", &error);
+    if (NULL == error)
+    {
+        priority->nice = CLAMP (niceness, 0, 19);
+    }
+    else if (!g_error_matches (error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_KEY_NOT_FOUND))
+    {
+        g_warning ("Ignoring niceness of “%s”: %s", group, error->message);
+    }
+
+    io_class = g_key_file_get_string (key_file, group, "IOClass", NULL);
+    if (g_strcmp0 (io_class, "default") == 0)
+    {
+        priority->io_class = REPORTD_EVENT_IO_CLASS_DEFAULT;
+    }
+    else if (g_strcmp0 (io_class, "best-effort") == 0)
+    {
+        priority->io_class = REPORTD_EVENT_IO_CLASS_BEST_EFFORT;
+    }
+    else if (g_strcmp0 (io_class, "idle") == 0)
+    {
+        priority->io_class = REPORTD_EVENT_IO_CLASS_IDLE;
+    }
+    else if (NULL != io_class)
+    {
+        g_warning ("Ignoring unknown I/O class “%s” of “%s”", io_class, group);
+    }
+
+    scheduler = g_key_file_get_string (key_file, group, "Scheduler", NULL);
+    if (g_strcmp0 (scheduler, "default") == 0)
+    {
+        priority->scheduler = REPORTD_EVENT_SCHEDULER_DEFAULT;
+    }
+    else if (g_strcmp0 (scheduler, "batch") == 0)
+    {
+        priority->scheduler = REPORTD_EVENT_SCHEDULER_BATCH;
+    }
+    else if (g_strcmp0 (scheduler, "idle") == 0)
+    {
+        priority->scheduler = REPORTD_EVENT_SCHEDULER_IDLE;
+    }
+    else if (NULL != scheduler)
+    {
+        g_warning ("Ignoring unknown scheduler “%s” of “%s”", scheduler, group);
+    }
+}
+
+static void
+reportd_event_registry_load (ReportdEventRegistry *self)
+{
+    g_autoptr (GKeyFile) key_file = NULL;
+    g_autoptr (GError) error = NULL;
+    g_auto (GStrv) groups = NULL;
+
+    key_file = g_key_file_new ();
+
+    if (!g_key_file_load_from_file (key_file, self->path, G_KEY_FILE_NONE, &error))
+    {
+        if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+        {
+            g_warning ("Failed to load event configuration from “%s”: %s",
+                       self->path, error->message);
+        }
+
+        return;
+    }
+
+    groups = g_key_file_get_groups (key_file, NULL);
+
+    for (char **group = groups; NULL != *group; group++)
+    {
+        ReportdEventInfo *info;
+
+        if (g_str_has_prefix (*group, REPORTD_EVENT_REGISTRY_WORKFLOW_PREFIX))
+        {
+            const char *workflow;
+
+            workflow = *group + strlen (REPORTD_EVENT_REGISTRY_WORKFLOW_PREFIX);
+
+            g_hash_table_replace (self->workflow_timeouts, g_strdup (workflow),
+                                  GUINT_TO_POINTER (reportd_event_registry_get_timeout (key_file, *group)));
+            if (g_key_file_get_boolean (key_file, *group, "Deduplicate", NULL))
+            {
+                g_hash_table_add (self->deduplicated_workflows, g_strdup (workflow));
+            }
+
+            continue;
+        }
+
+        info = g_new0 (ReportdEventInfo, 1);
+
+        info->reads = g_key_file_get_string_list (key_file, *group, "Reads", NULL, NULL);
+        info->writes = g_key_file_get_string_list (key_file, *group, "Writes", NULL, NULL);
+        info->after = g_key_file_get_string_list (key_file, *group, "After", NULL, NULL);
+        info->timeout = reportd_event_registry_get_timeout (key_file, *group);
+        info->pure = g_key_file_get_boolean (key_file, *group, "Pure", NULL);
+        reportd_event_registry_get_priority (key_file, *group, &info->priority);
+
+        if (info->pure && NULL == info->reads)
+        {
+            g_warning ("Event “%s” is pure, but does not declare what it reads, ignoring", *group);
+
+            info->pure = false;
+        }
+        if (info->pure && NULL == info->writes)
+        {
+            g_warning ("Event “%s” is pure, but does not declare what it writes, ignoring", *group);
+
+            info->pure = false;
+        }
+
+        g_hash_table_replace (self->events, g_strdup (*group), info);
+    }
+}
+
+static void
+reportd_event_registry_init (ReportdEventRegistry *self)
+{
+    self->events = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                          g_free, (GDestroyNotify) reportd_event_info_free);
+    self->workflow_timeouts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    self->deduplicated_workflows = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+}
+
+static void
+reportd_event_registry_set_property (GObject      *object,
+                                     unsigned int  property_id,
+                                     const GValue *value,
+                                     GParamSpec   *pspec)
+{
+    ReportdEventRegistry *self;
+
+    self = REPORTD_EVENT_REGISTRY (object);
+
+    switch (property_id)
+    {
+        case PROP_PATH:
+        {
+            self->path = g_value_dup_string (value);
+        }
+        break;
+
+        default:
+        {
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        }
+    }
+}
+
+static void
+reportd_event_registry_get_property (GObject      *object,
+                                     unsigned int  property_id,
+                                     GValue       *value,
+                                     GParamSpec   *pspec)
+{
+    ReportdEventRegistry *self;
+
+    self = REPORTD_EVENT_REGISTRY (object);
+
+    switch (property_id)
+    {
+        case PROP_PATH:
+        {
+            g_value_set_string (value, self->path);
+        }
+        break;
+
+        default:
+        {
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        }
+    }
+}
+
+static void
+reportd_event_registry_constructed (GObject *object)
+{
+    ReportdEventRegistry *self;
+
+    self = REPORTD_EVENT_REGISTRY (object);
+
+    G_OBJECT_CLASS (reportd_event_registry_parent_class)->constructed (object);
+
+    reportd_event_registry_load (self);
+}
+
+static void
+reportd_event_registry_finalize (GObject *object)
+{
+    ReportdEventRegistry *self;
+
+    self = REPORTD_EVENT_REGISTRY (object);
+
+    g_clear_pointer (&self->events, g_hash_table_destroy);
+    g_clear_pointer (&self->workflow_timeouts, g_hash_table_destroy);
+    g_clear_pointer (&self->deduplicated_workflows, g_hash_table_destroy);
+    g_clear_pointer (&self->path, g_free);
+
+    G_OBJECT_CLASS (reportd_event_registry_parent_class)->finalize (object);
+}
+
+static void
+reportd_event_registry_class_init (ReportdEventRegistryClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    object_class->set_property = reportd_event_registry_set_property;
+    object_class->get_property = reportd_event_registry_get_property;
+    object_class->constructed = reportd_event_registry_constructed;
+    object_class->finalize = reportd_event_registry_finalize;
+
+    properties[PROP_PATH] = g_param_spec_string ("path", "Path",
+                                                 "Path to the event configuration file",
+                                                 NULL,
+                                                 (G_PARAM_READWRITE |
+                                                  G_PARAM_CONSTRUCT_ONLY |
+                                                  G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_properties (object_class, N_PROPERTIES, properties);
+}
+
+ReportdEventRegistry *
+reportd_event_registry_new (const char *path)
+{
+    return g_object_new (REPORTD_TYPE_EVENT_REGISTRY,
+                         "path", path,
+                         NULL);
+}
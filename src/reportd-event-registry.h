@@ -0,0 +1,90 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define REPORTD_TYPE_EVENT_REGISTRY reportd_event_registry_get_type ()
+
+G_DECLARE_FINAL_TYPE (ReportdEventRegistry, reportd_event_registry, REPORTD, EVENT_REGISTRY, GObject)
+
+typedef enum
+{
+    /* Left as the daemon has it */
+    REPORTD_EVENT_IO_CLASS_DEFAULT,
+    /* Best effort, at the lowest level */
+    REPORTD_EVENT_IO_CLASS_BEST_EFFORT,
+    REPORTD_EVENT_IO_CLASS_IDLE,
+} ReportdEventIOClass;
+
+typedef enum
+{
+    /* Left as the daemon has it */
+    REPORTD_EVENT_SCHEDULER_DEFAULT,
+    REPORTD_EVENT_SCHEDULER_BATCH,
+    REPORTD_EVENT_SCHEDULER_IDLE,
+} ReportdEventScheduler;
+
+/* How much of the machine the handlers of an event get. Analysis is left
+ * to run in the background unless configured otherwise, everything else is
+ * left alone.
+ */
+typedef struct
+{
+    /* Added to the niceness of the daemon */
+    int nice;
+    ReportdEventIOClass io_class;
+    ReportdEventScheduler scheduler;
+} ReportdEventPriority;
+
+/* What reportd knows about an event on top of the libreport configuration,
+ * read from a group named after the event in events.conf. Groups named
+ * “Workflow <name>” apply to whole workflows instead.
+ */
+typedef struct
+{
+    /* Problem elements the handlers read and write, NULL if not declared */
+    char **reads;
+    char **writes;
+    /* Events in the same workflow that have to finish first */
+    char **after;
+    /* Seconds the handlers may take in total, 0 for no limit */
+    unsigned int timeout;
+    /* The writes follow from the reads alone, so results can be reused */
+    bool pure;
+    ReportdEventPriority priority;
+} ReportdEventInfo;
+
+const ReportdEventInfo *reportd_event_registry_lookup               (ReportdEventRegistry   *registry,
+                                                                     const char             *event);
+unsigned int            reportd_event_registry_get_workflow_timeout (ReportdEventRegistry   *registry,
+                                                                     const char             *workflow);
+bool                    reportd_event_registry_get_workflow_deduplicate (ReportdEventRegistry *registry,
+                                                                         const char           *workflow);
+
+void                    reportd_event_priority_init_default         (ReportdEventPriority   *priority,
+                                                                     const char             *event);
+
+bool                    reportd_event_info_depends_on               (const ReportdEventInfo *info,
+                                                                     const char             *event,
+                                                                     const ReportdEventInfo *event_info);
+
+ReportdEventRegistry   *reportd_event_registry_new                  (const char             *path);
+
+G_END_DECLS
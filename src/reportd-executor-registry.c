@@ -0,0 +1,355 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#include "reportd-executor-registry.h"
+
+struct _ReportdExecutorRegistry
+{
+    GObject parent;
+
+    char *path;
+    /* Event name → ReportdEventExecutor */
+    GHashTable *executors;
+};
+
+struct _ReportdEventRun
+{
+    char *event;
+    char *problem_directory;
+    /* The event configuration, as VAR=value */
+    GStrv environment;
+    GCancellable *cancellable;
+    /* Lines logged by the executor, emitted as progress once it is done */
+    GPtrArray *log;
+};
+
+G_DEFINE_TYPE (ReportdExecutorRegistry, reportd_executor_registry, G_TYPE_OBJECT)
+
+enum
+{
+    PROP_0,
+    PROP_PATH,
+    N_PROPERTIES,
+};
+
+static GParamSpec *properties[N_PROPERTIES];
+
+void
+reportd_executor_registry_add (ReportdExecutorRegistry *self,
+                               const char              *event,
+                               ReportdEventExecutor     executor)
+{
+    g_return_if_fail (REPORTD_IS_EXECUTOR_REGISTRY (self));
+    g_return_if_fail (NULL != event);
+    g_return_if_fail (NULL != executor);
+
+    if (g_hash_table_contains (self->executors, event))
+    {
+        g_warning ("Event “%s” already has a native executor, ignoring another one", event);
+
+        return;
+    }
+
+    g_hash_table_insert (self->executors, g_strdup (event), (gpointer) executor);
+
+    g_debug ("Event “%s” will be run natively", event);
+}
+
+ReportdEventExecutor
+reportd_executor_registry_lookup (ReportdExecutorRegistry *self,
+                                  const char              *event)
+{
+    g_return_val_if_fail (REPORTD_IS_EXECUTOR_REGISTRY (self), NULL);
+
+    return (ReportdEventExecutor) g_hash_table_lookup (self->executors, event);
+}
+
+static void
+reportd_executor_registry_load_plugin (ReportdExecutorRegistry *self,
+                                       const char              *path)
+{
+    GModule *module;
+    ReportdPluginRegisterFunc register_func;
+
+    module = g_module_open (path, G_MODULE_BIND_LOCAL);
+    if (NULL == module)
+    {
+        g_warning ("Failed to load plugin “%s”: %s", path, g_module_error ());
+
+        return;
+    }
+
+    if (!g_module_symbol (module, REPORTD_PLUGIN_REGISTER_SYMBOL, (gpointer *) &register_func))
+    {
+        g_warning ("Plugin “%s” does not export “%s”, ignoring",
+                   path, REPORTD_PLUGIN_REGISTER_SYMBOL);
+
+        g_module_close (module);
+
+        return;
+    }
+
+    /* Executors are only looked up, never removed, so the code has to stay
+     * for as long as the daemon runs.
+     */
+    g_module_make_resident (module);
+
+    register_func (self);
+}
+
+static void
+reportd_executor_registry_load (ReportdExecutorRegistry *self)
+{
+    g_autoptr (GDir) directory = NULL;
+    g_autoptr (GError) error = NULL;
+    const char *name;
+
+    if (!g_module_supported ())
+    {
+        return;
+    }
+
+    directory = g_dir_open (self->path, 0, &error);
+    if (NULL == directory)
+    {
+        if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+        {
+            g_warning ("Failed to list plugins in “%s”: %s", self->path, error->message);
+        }
+
+        return;
+    }
+
+    while (NULL != (name = g_dir_read_name (directory)))
+    {
+        g_autofree char *path = NULL;
+
+        if (!g_str_has_suffix (name, "." G_MODULE_SUFFIX))
+        {
+            continue;
+        }
+
+        path = g_build_filename (self->path, name, NULL);
+
+        reportd_executor_registry_load_plugin (self, path);
+    }
+}
+
+static void
+reportd_executor_registry_init (ReportdExecutorRegistry *self)
+{
+    self->executors = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+}
+
+static void
+reportd_executor_registry_set_property (GObject      *object,
+                                        unsigned int  property_id,
+                                        const GValue *value,
+                                        GParamSpec   *pspec)
+{
+    ReportdExecutorRegistry *self;
+
+    self = REPORTD_EXECUTOR_REGISTRY (object);
+
+    switch (property_id)
+    {
+        case PROP_PATH:
+        {
+            self->path = g_value_dup_string (value);
+        }
+        break;
+
+        default:
+        {
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        }
+    }
+}
+
+static void
+reportd_executor_registry_get_property (GObject      *object,
+                                        unsigned int  property_id,
+                                        GValue       *value,
+                                        GParamSpec   *pspec)
+{
+    ReportdExecutorRegistry *self;
+
+    self = REPORTD_EXECUTOR_REGISTRY (object);
+
+    switch (property_id)
+    {
+        case PROP_PATH:
+        {
+            g_value_set_string (value, self->path);
+        }
+        break;
+
+        default:
+        {
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        }
+    }
+}
+
+static void
+reportd_executor_registry_constructed (GObject *object)
+{
+    ReportdExecutorRegistry *self;
+
+    self = REPORTD_EXECUTOR_REGISTRY (object);
+
+    G_OBJECT_CLASS (reportd_executor_registry_parent_class)->constructed (object);
+
+    reportd_executor_registry_load (self);
+}
+
+static void
+reportd_executor_registry_finalize (GObject *object)
+{
+    ReportdExecutorRegistry *self;
+
+    self = REPORTD_EXECUTOR_REGISTRY (object);
+
+    g_clear_pointer (&self->executors, g_hash_table_destroy);
+    g_clear_pointer (&self->path, g_free);
+
+    G_OBJECT_CLASS (reportd_executor_registry_parent_class)->finalize (object);
+}
+
+static void
+reportd_executor_registry_class_init (ReportdExecutorRegistryClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    object_class->set_property = reportd_executor_registry_set_property;
+    object_class->get_property = reportd_executor_registry_get_property;
+    object_class->constructed = reportd_executor_registry_constructed;
+    object_class->finalize = reportd_executor_registry_finalize;
+
+    properties[PROP_PATH] = g_param_spec_string ("path", "Path",
+                                                 "Path to the plugin directory",
+                                                 NULL,
+                                                 (G_PARAM_READWRITE |
+                                                  G_PARAM_CONSTRUCT_ONLY |
+                                                  G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_properties (object_class, N_PROPERTIES, properties);
+}
+
+ReportdExecutorRegistry *
+reportd_executor_registry_new (const char *path)
+{
+    return g_object_new (REPORTD_TYPE_EXECUTOR_REGISTRY,
+                         "path", path,
+                         NULL);
+}
+
+/*** Event runs ***/
+
+const char *
+reportd_event_run_get_event (ReportdEventRun *run)
+{
+    g_return_val_if_fail (NULL != run, NULL);
+
+    return run->event;
+}
+
+const char *
+reportd_event_run_get_problem_directory (ReportdEventRun *run)
+{
+    g_return_val_if_fail (NULL != run, NULL);
+
+    return run->problem_directory;
+}
+
+/* Looks up a variable of the event configuration, which the commands would
+ * have found in their environment.
+ */
+const char *
+reportd_event_run_getenv (ReportdEventRun *run,
+                          const char      *variable)
+{
+    g_return_val_if_fail (NULL != run, NULL);
+
+    return g_environ_getenv (run->environment, variable);
+}
+
+GCancellable *
+reportd_event_run_get_cancellable (ReportdEventRun *run)
+{
+    g_return_val_if_fail (NULL != run, NULL);
+
+    return run->cancellable;
+}
+
+void
+reportd_event_run_log (ReportdEventRun *run,
+                       const char      *format,
+                       ...)
+{
+    va_list arguments;
+
+    g_return_if_fail (NULL != run);
+
+    va_start (arguments, format);
+    g_ptr_array_add (run->log, g_strdup_vprintf (format, arguments));
+    va_end (arguments);
+}
+
+ReportdEventRun *
+reportd_event_run_new (const char         *event,
+                       const char         *problem_directory,
+                       const char * const *environment,
+                       GCancellable       *cancellable)
+{
+    ReportdEventRun *run;
+
+    run = g_new0 (ReportdEventRun, 1);
+
+    run->event = g_strdup (event);
+    run->problem_directory = g_strdup (problem_directory);
+    run->environment = g_strdupv ((char **) environment);
+    run->cancellable = g_object_ref (cancellable);
+    run->log = g_ptr_array_new_with_free_func (g_free);
+
+    return run;
+}
+
+/* Takes the lines logged so far, NULL-terminated. */
+GStrv
+reportd_event_run_steal_log (ReportdEventRun *run)
+{
+    GPtrArray *log;
+
+    g_return_val_if_fail (NULL != run, NULL);
+
+    log = g_steal_pointer (&run->log);
+    run->log = g_ptr_array_new_with_free_func (g_free);
+
+    g_ptr_array_add (log, NULL);
+
+    return (GStrv) g_ptr_array_free (log, FALSE);
+}
+
+void
+reportd_event_run_free (ReportdEventRun *run)
+{
+    g_free (run->event);
+    g_free (run->problem_directory);
+    g_strfreev (run->environment);
+    g_object_unref (run->cancellable);
+    g_ptr_array_unref (run->log);
+
+    g_free (run);
+}
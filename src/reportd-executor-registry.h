@@ -0,0 +1,72 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include <gio/gio.h>
+#include <gmodule.h>
+
+G_BEGIN_DECLS
+
+#define REPORTD_TYPE_EXECUTOR_REGISTRY reportd_executor_registry_get_type ()
+
+G_DECLARE_FINAL_TYPE (ReportdExecutorRegistry, reportd_executor_registry, REPORTD, EXECUTOR_REGISTRY, GObject)
+
+/* A single run of an event by a native executor. */
+typedef struct _ReportdEventRun ReportdEventRun;
+
+/* Runs an event in a worker thread of the daemon, in place of the commands
+ * libreport has for it, and returns what the commands would have exited
+ * with. Executors check the conditions of the event rules themselves, stop
+ * early if the cancellable of the run is triggered and cannot ask the
+ * client anything.
+ */
+typedef int (*ReportdEventExecutor) (ReportdEventRun *run);
+
+/* Plugins are modules in the plugin directory exporting a function of this
+ * name, which adds their executors to the registry when it is loaded.
+ */
+#define REPORTD_PLUGIN_REGISTER_SYMBOL "reportd_plugin_register"
+
+typedef void (*ReportdPluginRegisterFunc) (ReportdExecutorRegistry *registry);
+
+G_MODULE_EXPORT void     reportd_plugin_register                 (ReportdExecutorRegistry *registry);
+
+void                     reportd_executor_registry_add           (ReportdExecutorRegistry *registry,
+                                                                  const char              *event,
+                                                                  ReportdEventExecutor     executor);
+ReportdEventExecutor     reportd_executor_registry_lookup        (ReportdExecutorRegistry *registry,
+                                                                  const char              *event);
+
+ReportdExecutorRegistry *reportd_executor_registry_new           (const char              *path);
+
+const char              *reportd_event_run_get_event             (ReportdEventRun         *run);
+const char              *reportd_event_run_get_problem_directory (ReportdEventRun         *run);
+const char              *reportd_event_run_getenv                (ReportdEventRun         *run,
+                                                                  const char              *variable);
+GCancellable            *reportd_event_run_get_cancellable       (ReportdEventRun         *run);
+void                     reportd_event_run_log                   (ReportdEventRun         *run,
+                                                                  const char              *format,
+                                                                  ...) G_GNUC_PRINTF (2, 3);
+
+ReportdEventRun         *reportd_event_run_new                   (const char              *event,
+                                                                  const char              *problem_directory,
+                                                                  const char * const      *environment,
+                                                                  GCancellable            *cancellable);
+GStrv                    reportd_event_run_steal_log             (ReportdEventRun         *run);
+void                     reportd_event_run_free                  (ReportdEventRun         *run);
+
+G_END_DECLS
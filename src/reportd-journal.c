@@ -0,0 +1,436 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#include "reportd-journal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
+
+/* Records are single lines of tab-separated, C-escaped fields:
+ *
+ *   event   <event> [<element>…]
+ *   answer  <prompt type> <message> <answer>
+ *   end
+ *
+ * An end record is written when a run fails, so that the answers before it
+ * are only ever given again to a run resuming after the daemon went away.
+ *
+ * A line that was cut short by the daemon going away has no newline at the
+ * end and is ignored on reading.
+ */
+#define REPORTD_JOURNAL_EVENT  "event"
+#define REPORTD_JOURNAL_ANSWER "answer"
+#define REPORTD_JOURNAL_END    "end"
+
+struct _ReportdJournal
+{
+    GObject parent;
+
+    char *path;
+    int fd;
+
+    /* Event name → GStrv of the elements it changed */
+    GHashTable *events;
+    /* “type:message” → answer */
+    GHashTable *answers;
+};
+
+G_DEFINE_TYPE (ReportdJournal, reportd_journal, G_TYPE_OBJECT)
+
+enum
+{
+    PROP_0,
+    PROP_PATH,
+    N_PROPERTIES,
+};
+
+static GParamSpec *properties[N_PROPERTIES];
+
+char *
+reportd_journal_get_answer_key (unsigned int  type,
+                                const char   *message)
+{
+    return g_strdup_printf ("%u:%s", type, message);
+}
+
+bool
+reportd_journal_lookup_event (ReportdJournal      *self,
+                              const char          *event,
+                              const char * const **elements)
+{
+    char **value;
+
+    g_return_val_if_fail (REPORTD_IS_JOURNAL (self), false);
+
+    if (!g_hash_table_lookup_extended (self->events, event, NULL, (gpointer *) &value))
+    {
+        return false;
+    }
+
+    if (NULL != elements)
+    {
+        *elements = (const char * const *) value;
+    }
+
+    return true;
+}
+
+/* Takes the answers given by a run that never came to an end, keyed by
+ * reportd_journal_get_answer_key().
+ */
+GHashTable *
+reportd_journal_steal_answers (ReportdJournal *self)
+{
+    GHashTable *answers;
+
+    g_return_val_if_fail (REPORTD_IS_JOURNAL (self), NULL);
+
+    answers = g_steal_pointer (&self->answers);
+    self->answers = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+    return answers;
+}
+
+/* Records are synced as they are appended, they are few and far between,
+ * and a record that is not on the disk is no good for resuming.
+ */
+static void
+reportd_journal_append (ReportdJournal     *self,
+                        const char * const *fields)
+{
+    g_autoptr (GString) line = NULL;
+
+    if (-1 == self->fd)
+    {
+        self->fd = open (self->path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0600);
+        if (-1 == self->fd)
+        {
+            g_warning ("Failed to open journal “%s”: %s", self->path, g_strerror (errno));
+
+            return;
+        }
+    }
+
+    line = g_string_new (NULL);
+
+    for (const char * const *field = fields; NULL != *field; field++)
+    {
+        g_autofree char *escaped = NULL;
+
+        escaped = g_strescape (*field, NULL);
+
+        if (field != fields)
+        {
+            g_string_append_c (line, '\t');
+        }
+        g_string_append (line, escaped);
+    }
+
+    g_string_append_c (line, '\n');
+
+    if (write (self->fd, line->str, line->len) != (ssize_t) line->len ||
+        fdatasync (self->fd) == -1)
+    {
+        g_warning ("Failed to write to journal “%s”: %s", self->path, g_strerror (errno));
+    }
+}
+
+void
+reportd_journal_add_event (ReportdJournal     *self,
+                           const char         *event,
+                           const char * const *elements)
+{
+    g_autoptr (GPtrArray) fields = NULL;
+
+    g_return_if_fail (REPORTD_IS_JOURNAL (self));
+    g_return_if_fail (NULL != event);
+
+    fields = g_ptr_array_new ();
+
+    g_ptr_array_add (fields, (gpointer) REPORTD_JOURNAL_EVENT);
+    g_ptr_array_add (fields, (gpointer) event);
+
+    for (; NULL != elements && NULL != *elements; elements++)
+    {
+        g_ptr_array_add (fields, (gpointer) *elements);
+    }
+
+    g_ptr_array_add (fields, NULL);
+
+    reportd_journal_append (self, (const char * const *) fields->pdata);
+
+    g_hash_table_replace (self->events, g_strdup (event), g_strdupv ((char **) elements));
+}
+
+void
+reportd_journal_add_answer (ReportdJournal *self,
+                            unsigned int    type,
+                            const char     *message,
+                            const char     *answer)
+{
+    g_autofree char *type_string = NULL;
+    const char *fields[5];
+
+    g_return_if_fail (REPORTD_IS_JOURNAL (self));
+
+    if (NULL == message || NULL == answer)
+    {
+        return;
+    }
+
+    type_string = g_strdup_printf ("%u", type);
+
+    fields[0] = REPORTD_JOURNAL_ANSWER;
+    fields[1] = type_string;
+    fields[2] = message;
+    fields[3] = answer;
+    fields[4] = NULL;
+
+    reportd_journal_append (self, fields);
+
+    g_hash_table_replace (self->answers,
+                          reportd_journal_get_answer_key (type, message),
+                          g_strdup (answer));
+}
+
+/* Called when a run fails, leaving the completed events to be skipped by the
+ * next one, but not the answers.
+ */
+void
+reportd_journal_end_run (ReportdJournal *self)
+{
+    const char *fields[] = { REPORTD_JOURNAL_END, NULL };
+
+    g_return_if_fail (REPORTD_IS_JOURNAL (self));
+
+    reportd_journal_append (self, fields);
+
+    g_hash_table_remove_all (self->answers);
+}
+
+/* Called once the workflow is through, there being nothing left to resume. */
+void
+reportd_journal_remove (ReportdJournal *self)
+{
+    g_return_if_fail (REPORTD_IS_JOURNAL (self));
+
+    if (-1 != self->fd)
+    {
+        close (self->fd);
+
+        self->fd = -1;
+    }
+
+    if (g_unlink (self->path) == -1 && ENOENT != errno)
+    {
+        g_warning ("Failed to remove journal “%s”: %s", self->path, g_strerror (errno));
+    }
+
+    g_hash_table_remove_all (self->events);
+    g_hash_table_remove_all (self->answers);
+}
+
+static void
+reportd_journal_load_record (ReportdJournal *self,
+                             char          **fields)
+{
+    unsigned int n_fields;
+
+    n_fields = g_strv_length (fields);
+
+    for (unsigned int i = 0; i < n_fields; i++)
+    {
+        char *field;
+
+        field = fields[i];
+        fields[i] = g_strcompress (field);
+
+        g_free (field);
+    }
+
+    if (n_fields >= 2 && g_strcmp0 (fields[0], REPORTD_JOURNAL_EVENT) == 0)
+    {
+        g_hash_table_replace (self->events, g_strdup (fields[1]), g_strdupv (fields + 2));
+    }
+    else if (4 == n_fields && g_strcmp0 (fields[0], REPORTD_JOURNAL_ANSWER) == 0)
+    {
+        unsigned int type;
+
+        type = (unsigned int) g_ascii_strtoull (fields[1], NULL, 10);
+
+        g_hash_table_replace (self->answers,
+                              reportd_journal_get_answer_key (type, fields[2]),
+                              g_strdup (fields[3]));
+    }
+    else if (1 == n_fields && g_strcmp0 (fields[0], REPORTD_JOURNAL_END) == 0)
+    {
+        g_hash_table_remove_all (self->answers);
+    }
+    else
+    {
+        g_warning ("Ignoring malformed record in journal “%s”", self->path);
+    }
+}
+
+static void
+reportd_journal_load (ReportdJournal *self)
+{
+    g_autofree char *contents = NULL;
+    g_autoptr (GError) error = NULL;
+    char *line;
+    char *end;
+
+    if (!g_file_get_contents (self->path, &contents, NULL, &error))
+    {
+        if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+        {
+            g_warning ("Failed to read journal “%s”: %s", self->path, error->message);
+        }
+
+        return;
+    }
+
+    for (line = contents; NULL != (end = strchr (line, '\n')); line = end + 1)
+    {
+        g_auto (GStrv) fields = NULL;
+
+        *end = '\0';
+
+        fields = g_strsplit (line, "\t", -1);
+
+        reportd_journal_load_record (self, fields);
+    }
+}
+
+static void
+reportd_journal_init (ReportdJournal *self)
+{
+    self->fd = -1;
+    self->events = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                          g_free, (GDestroyNotify) g_strfreev);
+    self->answers = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+}
+
+static void
+reportd_journal_set_property (GObject      *object,
+                              unsigned int  property_id,
+                              const GValue *value,
+                              GParamSpec   *pspec)
+{
+    ReportdJournal *self;
+
+    self = REPORTD_JOURNAL (object);
+
+    switch (property_id)
+    {
+        case PROP_PATH:
+        {
+            self->path = g_value_dup_string (value);
+        }
+        break;
+
+        default:
+        {
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        }
+    }
+}
+
+static void
+reportd_journal_get_property (GObject      *object,
+                              unsigned int  property_id,
+                              GValue       *value,
+                              GParamSpec   *pspec)
+{
+    ReportdJournal *self;
+
+    self = REPORTD_JOURNAL (object);
+
+    switch (property_id)
+    {
+        case PROP_PATH:
+        {
+            g_value_set_string (value, self->path);
+        }
+        break;
+
+        default:
+        {
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        }
+    }
+}
+
+static void
+reportd_journal_constructed (GObject *object)
+{
+    ReportdJournal *self;
+
+    self = REPORTD_JOURNAL (object);
+
+    G_OBJECT_CLASS (reportd_journal_parent_class)->constructed (object);
+
+    reportd_journal_load (self);
+}
+
+static void
+reportd_journal_finalize (GObject *object)
+{
+    ReportdJournal *self;
+
+    self = REPORTD_JOURNAL (object);
+
+    if (-1 != self->fd)
+    {
+        close (self->fd);
+    }
+
+    g_clear_pointer (&self->events, g_hash_table_destroy);
+    g_clear_pointer (&self->answers, g_hash_table_destroy);
+    g_clear_pointer (&self->path, g_free);
+
+    G_OBJECT_CLASS (reportd_journal_parent_class)->finalize (object);
+}
+
+static void
+reportd_journal_class_init (ReportdJournalClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    object_class->set_property = reportd_journal_set_property;
+    object_class->get_property = reportd_journal_get_property;
+    object_class->constructed = reportd_journal_constructed;
+    object_class->finalize = reportd_journal_finalize;
+
+    properties[PROP_PATH] = g_param_spec_string ("path", "Path",
+                                                 "Path to the journal file",
+                                                 NULL,
+                                                 (G_PARAM_READWRITE |
+                                                  G_PARAM_CONSTRUCT_ONLY |
+                                                  G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_properties (object_class, N_PROPERTIES, properties);
+}
+
+ReportdJournal *
+reportd_journal_new (const char *path)
+{
+    return g_object_new (REPORTD_TYPE_JOURNAL,
+                         "path", path,
+                         NULL);
+}
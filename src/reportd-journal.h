@@ -0,0 +1,52 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define REPORTD_TYPE_JOURNAL reportd_journal_get_type ()
+
+/* Append-only record of how far a workflow got over a problem: the events
+ * that completed, the elements they changed and the answers given to their
+ * text prompts. Whatever was written before the daemon went away is read back
+ * when the journal is opened again.
+ */
+G_DECLARE_FINAL_TYPE (ReportdJournal, reportd_journal, REPORTD, JOURNAL, GObject)
+
+bool            reportd_journal_lookup_event   (ReportdJournal      *journal,
+                                                const char          *event,
+                                                const char * const **elements);
+GHashTable     *reportd_journal_steal_answers  (ReportdJournal      *journal);
+char           *reportd_journal_get_answer_key (unsigned int         type,
+                                                const char          *message);
+
+void            reportd_journal_add_event      (ReportdJournal      *journal,
+                                                const char          *event,
+                                                const char * const  *elements);
+void            reportd_journal_add_answer     (ReportdJournal      *journal,
+                                                unsigned int         type,
+                                                const char          *message,
+                                                const char          *answer);
+
+void            reportd_journal_end_run        (ReportdJournal      *journal);
+void            reportd_journal_remove         (ReportdJournal      *journal);
+
+ReportdJournal *reportd_journal_new            (const char          *path);
+
+G_END_DECLS
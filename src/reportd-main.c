@@ -1,6 +1,7 @@
 #include "reportd.h"
 
 #include <locale.h>
+#include <signal.h>
 #include <stdlib.h>
 
 #include <internal_libreport.h>
@@ -22,11 +23,17 @@ int
 main (int    argc,
       char **argv)
 {
-    bool use_system_bus;
+    gboolean use_system_bus;
+    gboolean use_all_buses;
+    int workers;
     const GOptionEntry option_entries[] =
     {
         { "system", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE,
           &use_system_bus, "Connect to the system bus", NULL },
+        { "all-buses", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE,
+          &use_all_buses, "Serve both the system and the session bus", NULL },
+        { "workers", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_INT,
+          &workers, "Maximum number of tasks running at once (default: number of processors)", "N" },
         { NULL, }
     };
     g_autoptr (GOptionContext) option_context = NULL;
@@ -39,6 +46,8 @@ main (int    argc,
     setlocale (LC_ALL, "");
 
     use_system_bus = false;
+    use_all_buses = false;
+    workers = 0;
     option_context = g_option_context_new (NULL);
 
     g_option_context_add_main_entries (option_context, option_entries, NULL);
@@ -48,10 +57,24 @@ main (int    argc,
 
         return EXIT_FAILURE;
     }
+    if (workers < 0)
+    {
+        g_warning ("Invalid number of workers: %d", workers);
+
+        return EXIT_FAILURE;
+    }
+    if (0 == workers)
+    {
+        workers = g_get_num_processors ();
+    }
 
-    daemon = reportd_daemon_new (use_system_bus);
+    daemon = reportd_daemon_new (use_system_bus || use_all_buses,
+                                 !use_system_bus || use_all_buses,
+                                 workers);
     sigint_source = g_unix_signal_add (SIGINT, on_signal_quit, daemon);
     sigterm_source = g_unix_signal_add (SIGTERM, on_signal_quit, daemon);
+    /* Answers to event handlers that have gone away are not worth dying for. */
+    signal (SIGPIPE, SIG_IGN);
 
     libreport_load_user_settings ("reportd");
 
@@ -0,0 +1,143 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#include "reportd-metrics.h"
+
+struct _ReportdMetrics
+{
+    GObject parent;
+
+    /* Event handler spawns and the time they took, in microseconds */
+    guint64 spawn_count;
+    guint64 spawn_latency_total;
+    guint64 spawn_latency_max;
+    guint64 result_hits;
+    guint64 result_misses;
+    /* Event name → number of times its handlers ran out of time */
+    GHashTable *timeouts;
+};
+
+G_DEFINE_TYPE (ReportdMetrics, reportd_metrics, G_TYPE_OBJECT)
+
+void
+reportd_metrics_add_spawn (ReportdMetrics *self,
+                           gint64          latency)
+{
+    g_return_if_fail (REPORTD_IS_METRICS (self));
+
+    latency = MAX (latency, 0);
+
+    self->spawn_count++;
+    self->spawn_latency_total += latency;
+    self->spawn_latency_max = MAX (self->spawn_latency_max, (guint64) latency);
+}
+
+void
+reportd_metrics_add_timeout (ReportdMetrics *self,
+                             const char     *event)
+{
+    unsigned int count;
+
+    g_return_if_fail (REPORTD_IS_METRICS (self));
+
+    count = GPOINTER_TO_UINT (g_hash_table_lookup (self->timeouts, event));
+
+    g_hash_table_replace (self->timeouts, g_strdup (event), GUINT_TO_POINTER (count + 1));
+}
+
+void
+reportd_metrics_add_result_lookup (ReportdMetrics *self,
+                                   bool            hit)
+{
+    g_return_if_fail (REPORTD_IS_METRICS (self));
+
+    if (hit)
+    {
+        self->result_hits++;
+    }
+    else
+    {
+        self->result_misses++;
+    }
+}
+
+/* Returns a floating a{sv} dictionary, with latencies in microseconds. */
+GVariant *
+reportd_metrics_serialize (ReportdMetrics *self)
+{
+    g_autoptr (GVariantBuilder) builder = NULL;
+    g_autoptr (GVariantBuilder) timeouts_builder = NULL;
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+
+    g_return_val_if_fail (REPORTD_IS_METRICS (self), NULL);
+
+    builder = g_variant_builder_new (G_VARIANT_TYPE_VARDICT);
+    timeouts_builder = g_variant_builder_new (G_VARIANT_TYPE ("a{su}"));
+
+    g_hash_table_iter_init (&iter, self->timeouts);
+
+    while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+        g_variant_builder_add (timeouts_builder, "{su}", key, GPOINTER_TO_UINT (value));
+    }
+
+    g_variant_builder_add (builder, "{sv}", "spawn-count",
+                           g_variant_new_uint64 (self->spawn_count));
+    g_variant_builder_add (builder, "{sv}", "spawn-latency-total",
+                           g_variant_new_uint64 (self->spawn_latency_total));
+    g_variant_builder_add (builder, "{sv}", "spawn-latency-max",
+                           g_variant_new_uint64 (self->spawn_latency_max));
+    g_variant_builder_add (builder, "{sv}", "result-cache-hits",
+                           g_variant_new_uint64 (self->result_hits));
+    g_variant_builder_add (builder, "{sv}", "result-cache-misses",
+                           g_variant_new_uint64 (self->result_misses));
+    g_variant_builder_add (builder, "{sv}", "event-timeouts",
+                           g_variant_builder_end (timeouts_builder));
+
+    return g_variant_builder_end (builder);
+}
+
+static void
+reportd_metrics_init (ReportdMetrics *self)
+{
+    self->timeouts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+}
+
+static void
+reportd_metrics_finalize (GObject *object)
+{
+    ReportdMetrics *self;
+
+    self = REPORTD_METRICS (object);
+
+    g_clear_pointer (&self->timeouts, g_hash_table_destroy);
+
+    G_OBJECT_CLASS (reportd_metrics_parent_class)->finalize (object);
+}
+
+static void
+reportd_metrics_class_init (ReportdMetricsClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    object_class->finalize = reportd_metrics_finalize;
+}
+
+ReportdMetrics *
+reportd_metrics_new (void)
+{
+    return g_object_new (REPORTD_TYPE_METRICS, NULL);
+}
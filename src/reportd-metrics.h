@@ -0,0 +1,41 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define REPORTD_TYPE_METRICS reportd_metrics_get_type ()
+
+/* Counters describing the daemon’s operation since it started, only to be
+ * touched from the main thread.
+ */
+G_DECLARE_FINAL_TYPE (ReportdMetrics, reportd_metrics, REPORTD, METRICS, GObject)
+
+void            reportd_metrics_add_spawn          (ReportdMetrics *metrics,
+                                                    gint64          latency);
+void            reportd_metrics_add_timeout        (ReportdMetrics *metrics,
+                                                    const char     *event);
+void            reportd_metrics_add_result_lookup  (ReportdMetrics *metrics,
+                                                    bool            hit);
+
+GVariant       *reportd_metrics_serialize          (ReportdMetrics *metrics);
+
+ReportdMetrics *reportd_metrics_new                (void);
+
+G_END_DECLS
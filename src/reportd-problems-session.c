@@ -0,0 +1,549 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#include "reportd-problems-session.h"
+
+typedef enum
+{
+    REPORTD_PROBLEMS_SESSION_AUTHORIZATION_NONE,
+    REPORTD_PROBLEMS_SESSION_AUTHORIZATION_PENDING,
+    REPORTD_PROBLEMS_SESSION_AUTHORIZATION_GRANTED,
+} ReportdProblemsSessionAuthorization;
+
+struct _ReportdProblemsSession
+{
+    GObject parent_instance;
+
+    GDBusConnection *connection;
+    GDBusProxy *session_proxy;
+    /* Requests for the session proxy waiting for the setup in flight */
+    GList *proxy_waiters;
+    bool connecting;
+
+    ReportdProblemsSessionAuthorization authorization;
+    /* Authorization requests waiting for the outcome of the one in flight */
+    GList *pending;
+};
+
+G_DEFINE_TYPE (ReportdProblemsSession, reportd_problems_session, G_TYPE_OBJECT)
+
+enum
+{
+    PROP_0,
+    PROP_CONNECTION,
+    N_PROPERTIES,
+};
+
+static GParamSpec *properties[N_PROPERTIES];
+
+static void
+reportd_problems_session_complete_pending (ReportdProblemsSession *self,
+                                           const GError           *error)
+{
+    g_autoptr (GList) pending = NULL;
+
+    pending = g_steal_pointer (&self->pending);
+
+    for (GList *l = pending; NULL != l; l = l->next)
+    {
+        g_autoptr (GTask) task = NULL;
+
+        task = l->data;
+
+        if (NULL != error)
+        {
+            g_task_return_error (task, g_error_copy (error));
+        }
+        else
+        {
+            g_task_return_boolean (task, true);
+        }
+    }
+}
+
+static void
+reportd_problems_session_set_authorization (ReportdProblemsSession              *self,
+                                            ReportdProblemsSessionAuthorization  authorization,
+                                            const GError                        *error)
+{
+    self->authorization = authorization;
+
+    switch (authorization)
+    {
+        case REPORTD_PROBLEMS_SESSION_AUTHORIZATION_GRANTED:
+        {
+            g_message ("Problems session authorized");
+
+            reportd_problems_session_complete_pending (self, NULL);
+        }
+        break;
+
+        case REPORTD_PROBLEMS_SESSION_AUTHORIZATION_NONE:
+        {
+            reportd_problems_session_complete_pending (self, error);
+        }
+        break;
+
+        default:
+        {
+        }
+    }
+}
+
+static void
+reportd_problems_session_on_g_signal (GDBusProxy *proxy,
+                                      char       *sender_name,
+                                      char       *signal_name,
+                                      GVariant   *parameters,
+                                      gpointer    user_data)
+{
+    ReportdProblemsSession *self;
+    int status;
+
+    self = REPORTD_PROBLEMS_SESSION (user_data);
+
+    if (g_strcmp0 (signal_name, "AuthorizationChanged") != 0)
+    {
+        return;
+    }
+
+    g_variant_get_child (parameters, 0, "i", &status);
+
+    switch (status)
+    {
+        case 0:
+        {
+            reportd_problems_session_set_authorization (self,
+                                                        REPORTD_PROBLEMS_SESSION_AUTHORIZATION_GRANTED,
+                                                        NULL);
+        }
+        break;
+
+        case 1:
+        {
+            self->authorization = REPORTD_PROBLEMS_SESSION_AUTHORIZATION_PENDING;
+        }
+        break;
+
+        default:
+        {
+            g_autoptr (GError) error = NULL;
+
+            error = g_error_new (G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                                 "Authorization has been lost or it failed");
+
+            reportd_problems_session_set_authorization (self,
+                                                        REPORTD_PROBLEMS_SESSION_AUTHORIZATION_NONE,
+                                                        error);
+        }
+    }
+}
+
+static void
+reportd_problems_session_complete_proxy_waiters (ReportdProblemsSession *self,
+                                                 const GError           *error)
+{
+    g_autoptr (GList) waiters = NULL;
+
+    self->connecting = false;
+
+    waiters = g_steal_pointer (&self->proxy_waiters);
+
+    for (GList *l = waiters; NULL != l; l = l->next)
+    {
+        g_autoptr (GTask) task = NULL;
+
+        task = l->data;
+
+        if (NULL != error)
+        {
+            g_task_return_error (task, g_error_copy (error));
+        }
+        else
+        {
+            g_task_return_pointer (task, g_object_ref (self->session_proxy), g_object_unref);
+        }
+    }
+}
+
+static void
+reportd_problems_session_on_session_proxy_created (GObject      *source_object,
+                                                   GAsyncResult *res,
+                                                   gpointer      user_data)
+{
+    g_autoptr (ReportdProblemsSession) self = NULL;
+    g_autoptr (GError) error = NULL;
+
+    self = REPORTD_PROBLEMS_SESSION (user_data);
+    self->session_proxy = g_dbus_proxy_new_finish (res, &error);
+    if (NULL == self->session_proxy)
+    {
+        g_warning ("Creating Problems2 session proxy failed: %s", error->message);
+
+        reportd_problems_session_complete_proxy_waiters (self, error);
+
+        return;
+    }
+
+    g_signal_connect (self->session_proxy, "g-signal",
+                      G_CALLBACK (reportd_problems_session_on_g_signal), self);
+
+    reportd_problems_session_complete_proxy_waiters (self, NULL);
+}
+
+static void
+reportd_problems_session_on_get_session_called (GObject      *source_object,
+                                                GAsyncResult *res,
+                                                gpointer      user_data)
+{
+    g_autoptr (ReportdProblemsSession) self = NULL;
+    g_autoptr (GVariant) tuple = NULL;
+    g_autoptr (GError) error = NULL;
+    const char *session_path;
+
+    self = REPORTD_PROBLEMS_SESSION (user_data);
+    tuple = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source_object), res, &error);
+    if (NULL == tuple)
+    {
+        g_warning ("Getting Problems2 session failed: %s", error->message);
+
+        reportd_problems_session_complete_proxy_waiters (self, error);
+
+        return;
+    }
+
+    g_variant_get_child (tuple, 0, "&o", &session_path);
+
+    /* We only ever call methods and listen for AuthorizationChanged on the
+     * session, so there is no point in having the properties fetched.
+     */
+    g_dbus_proxy_new (self->connection,
+                      G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES,
+                      NULL,
+                      "org.freedesktop.problems",
+                      session_path,
+                      "org.freedesktop.Problems2.Session",
+                      NULL,
+                      reportd_problems_session_on_session_proxy_created,
+                      g_steal_pointer (&self));
+}
+
+void
+reportd_problems_session_connect (ReportdProblemsSession *self)
+{
+    g_return_if_fail (REPORTD_IS_PROBLEMS_SESSION (self));
+
+    if (NULL != self->session_proxy || self->connecting)
+    {
+        return;
+    }
+
+    g_message ("Setting up Problems2 session");
+
+    self->connecting = true;
+
+    g_dbus_connection_call (self->connection,
+                            "org.freedesktop.problems",
+                            "/org/freedesktop/Problems2",
+                            "org.freedesktop.Problems2",
+                            "GetSession",
+                            NULL,
+                            G_VARIANT_TYPE ("(o)"),
+                            G_DBUS_CALL_FLAGS_NONE,
+                            -1,
+                            NULL,
+                            reportd_problems_session_on_get_session_called,
+                            g_object_ref (self));
+}
+
+static void
+reportd_problems_session_get_proxy_async (ReportdProblemsSession *self,
+                                          GAsyncReadyCallback     callback,
+                                          gpointer                user_data)
+{
+    g_autoptr (GTask) task = NULL;
+
+    task = g_task_new (self, NULL, callback, user_data);
+
+    g_task_set_source_tag (task, reportd_problems_session_get_proxy_async);
+
+    if (NULL != self->session_proxy)
+    {
+        g_task_return_pointer (task, g_object_ref (self->session_proxy), g_object_unref);
+
+        return;
+    }
+
+    self->proxy_waiters = g_list_prepend (self->proxy_waiters, g_steal_pointer (&task));
+
+    reportd_problems_session_connect (self);
+}
+
+static GDBusProxy *
+reportd_problems_session_get_proxy_finish (ReportdProblemsSession  *self,
+                                           GAsyncResult            *result,
+                                           GError                 **error)
+{
+    g_return_val_if_fail (g_task_is_valid (result, self), NULL);
+
+    return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+static void
+reportd_problems_session_on_authorize_called (GObject      *source_object,
+                                              GAsyncResult *res,
+                                              gpointer      user_data)
+{
+    g_autoptr (ReportdProblemsSession) self = NULL;
+    g_autoptr (GVariant) tuple = NULL;
+    g_autoptr (GError) error = NULL;
+    int result;
+
+    self = REPORTD_PROBLEMS_SESSION (user_data);
+    tuple = g_dbus_proxy_call_finish (G_DBUS_PROXY (source_object), res, &error);
+    if (NULL == tuple)
+    {
+        reportd_problems_session_set_authorization (self,
+                                                    REPORTD_PROBLEMS_SESSION_AUTHORIZATION_NONE,
+                                                    error);
+
+        return;
+    }
+
+    /* AuthorizationChanged may have beaten us to it. */
+    if (self->authorization != REPORTD_PROBLEMS_SESSION_AUTHORIZATION_PENDING)
+    {
+        return;
+    }
+
+    g_variant_get_child (tuple, 0, "i", &result);
+
+    switch (result)
+    {
+        case 0:
+        {
+            reportd_problems_session_set_authorization (self,
+                                                        REPORTD_PROBLEMS_SESSION_AUTHORIZATION_GRANTED,
+                                                        NULL);
+        }
+        break;
+
+        /* Either our request or someone else’s is pending, the outcome
+         * will be announced by AuthorizationChanged.
+         */
+        case 1:
+        case 2:
+        {
+        }
+        break;
+
+        default:
+        {
+            error = g_error_new (G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                                 "Authorization failed");
+
+            reportd_problems_session_set_authorization (self,
+                                                        REPORTD_PROBLEMS_SESSION_AUTHORIZATION_NONE,
+                                                        error);
+        }
+    }
+}
+
+static void
+reportd_problems_session_on_proxy_ready (GObject      *source_object,
+                                         GAsyncResult *res,
+                                         gpointer      user_data)
+{
+    ReportdProblemsSession *self;
+    g_autoptr (GDBusProxy) session_proxy = NULL;
+    g_autoptr (GError) error = NULL;
+
+    self = REPORTD_PROBLEMS_SESSION (source_object);
+    session_proxy = reportd_problems_session_get_proxy_finish (self, res, &error);
+    if (NULL == session_proxy)
+    {
+        reportd_problems_session_set_authorization (self,
+                                                    REPORTD_PROBLEMS_SESSION_AUTHORIZATION_NONE,
+                                                    error);
+
+        return;
+    }
+
+    g_message ("Authorizing problems session");
+
+    g_dbus_proxy_call (session_proxy,
+                       "Authorize",
+                       g_variant_new ("(a{sv})", NULL),
+                       G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+                       reportd_problems_session_on_authorize_called,
+                       g_object_ref (self));
+}
+
+void
+reportd_problems_session_authorize_async (ReportdProblemsSession *self,
+                                          GCancellable           *cancellable,
+                                          GAsyncReadyCallback     callback,
+                                          gpointer                user_data)
+{
+    g_autoptr (GTask) task = NULL;
+
+    g_return_if_fail (REPORTD_IS_PROBLEMS_SESSION (self));
+
+    task = g_task_new (self, cancellable, callback, user_data);
+
+    g_task_set_source_tag (task, reportd_problems_session_authorize_async);
+
+    switch (self->authorization)
+    {
+        case REPORTD_PROBLEMS_SESSION_AUTHORIZATION_GRANTED:
+        {
+            g_task_return_boolean (task, true);
+        }
+        return;
+
+        case REPORTD_PROBLEMS_SESSION_AUTHORIZATION_PENDING:
+        {
+            self->pending = g_list_prepend (self->pending, g_steal_pointer (&task));
+        }
+        return;
+
+        default:
+        {
+        }
+    }
+
+    self->authorization = REPORTD_PROBLEMS_SESSION_AUTHORIZATION_PENDING;
+    self->pending = g_list_prepend (self->pending, g_steal_pointer (&task));
+
+    reportd_problems_session_get_proxy_async (self,
+                                              reportd_problems_session_on_proxy_ready,
+                                              NULL);
+}
+
+bool
+reportd_problems_session_authorize_finish (ReportdProblemsSession  *self,
+                                           GAsyncResult            *result,
+                                           GError                 **error)
+{
+    g_return_val_if_fail (g_task_is_valid (result, self), false);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static void
+reportd_problems_session_init (ReportdProblemsSession *self)
+{
+    self->authorization = REPORTD_PROBLEMS_SESSION_AUTHORIZATION_NONE;
+}
+
+static void
+reportd_problems_session_set_property (GObject      *object,
+                                       unsigned int  property_id,
+                                       const GValue *value,
+                                       GParamSpec   *pspec)
+{
+    ReportdProblemsSession *self;
+
+    self = REPORTD_PROBLEMS_SESSION (object);
+
+    switch (property_id)
+    {
+        case PROP_CONNECTION:
+        {
+            GDBusConnection *connection;
+
+            connection = g_value_get_object (value);
+
+            g_set_object (&self->connection, connection);
+        }
+        break;
+
+        default:
+        {
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        }
+    }
+}
+
+static void
+reportd_problems_session_get_property (GObject      *object,
+                                       unsigned int  property_id,
+                                       GValue       *value,
+                                       GParamSpec   *pspec)
+{
+    ReportdProblemsSession *self;
+
+    self = REPORTD_PROBLEMS_SESSION (object);
+
+    switch (property_id)
+    {
+        case PROP_CONNECTION:
+        {
+            g_value_set_object (value, self->connection);
+        }
+        break;
+
+        default:
+        {
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        }
+    }
+}
+
+static void
+reportd_problems_session_dispose (GObject *object)
+{
+    ReportdProblemsSession *self;
+
+    self = REPORTD_PROBLEMS_SESSION (object);
+
+    if (NULL != self->session_proxy)
+    {
+        g_signal_handlers_disconnect_by_data (self->session_proxy, self);
+    }
+
+    g_clear_object (&self->session_proxy);
+    g_clear_object (&self->connection);
+
+    G_OBJECT_CLASS (reportd_problems_session_parent_class)->dispose (object);
+}
+
+static void
+reportd_problems_session_class_init (ReportdProblemsSessionClass *klass)
+{
+    GObjectClass *object_class;
+
+    object_class = G_OBJECT_CLASS (klass);
+
+    object_class->set_property = reportd_problems_session_set_property;
+    object_class->get_property = reportd_problems_session_get_property;
+    object_class->dispose = reportd_problems_session_dispose;
+
+    properties[PROP_CONNECTION] = g_param_spec_object ("connection", "Connection",
+                                                       "The system bus connection",
+                                                       G_TYPE_DBUS_CONNECTION,
+                                                       (G_PARAM_READWRITE |
+                                                        G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_properties (object_class, N_PROPERTIES, properties);
+}
+
+ReportdProblemsSession *
+reportd_problems_session_new (GDBusConnection *connection)
+{
+    return g_object_new (REPORTD_TYPE_PROBLEMS_SESSION,
+                         "connection", connection,
+                         NULL);
+}
@@ -0,0 +1,40 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define REPORTD_TYPE_PROBLEMS_SESSION reportd_problems_session_get_type ()
+
+G_DECLARE_FINAL_TYPE (ReportdProblemsSession, reportd_problems_session,
+                      REPORTD, PROBLEMS_SESSION, GObject)
+
+void                    reportd_problems_session_connect          (ReportdProblemsSession  *session);
+
+void                    reportd_problems_session_authorize_async  (ReportdProblemsSession  *session,
+                                                                   GCancellable            *cancellable,
+                                                                   GAsyncReadyCallback      callback,
+                                                                   gpointer                 user_data);
+bool                    reportd_problems_session_authorize_finish (ReportdProblemsSession  *session,
+                                                                   GAsyncResult            *result,
+                                                                   GError                 **error);
+
+ReportdProblemsSession *reportd_problems_session_new              (GDBusConnection         *connection);
+
+G_END_DECLS
@@ -0,0 +1,305 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#include "reportd-report-index.h"
+
+#include <stdbool.h>
+
+/* How long a report is reused for, in microseconds, and for how many
+ * problems at most.
+ */
+#define REPORTD_REPORT_INDEX_TTL (24 * G_TIME_SPAN_HOUR)
+#define REPORTD_REPORT_INDEX_MAX_REPORTED 4096
+
+typedef struct
+{
+    ReportdReportIndexFunc func;
+    gpointer user_data;
+} ReportdReportIndexWaiter;
+
+typedef struct
+{
+    /* NULL while the report is in flight */
+    char *reported_to;
+    /* Monotonic time the report was recorded at */
+    gint64 reported_at;
+    /* ReportdReportIndexWaiter */
+    GQueue waiters;
+} ReportdReportIndexEntry;
+
+struct _ReportdReportIndex
+{
+    GObject parent;
+
+    /* “uid:workflow:duphash” → ReportdReportIndexEntry */
+    GHashTable *entries;
+};
+
+G_DEFINE_TYPE (ReportdReportIndex, reportd_report_index, G_TYPE_OBJECT)
+
+static void
+reportd_report_index_entry_free (ReportdReportIndexEntry *entry)
+{
+    g_free (entry->reported_to);
+    g_queue_clear_full (&entry->waiters, g_free);
+
+    g_free (entry);
+}
+
+/* Problems of different users are never taken for duplicates of each
+ * other, so that nobody learns where somebody else’s problem went.
+ */
+static char *
+reportd_report_index_get_key (const char *uid,
+                              const char *workflow,
+                              const char *duphash)
+{
+    return g_strdup_printf ("%s:%s:%s", NULL != uid? uid : "", workflow, duphash);
+}
+
+static bool
+reportd_report_index_entry_is_expired (ReportdReportIndexEntry *entry,
+                                       gint64                   now)
+{
+    return NULL != entry->reported_to && now - entry->reported_at > REPORTD_REPORT_INDEX_TTL;
+}
+
+/* Drops the reports that are too old to be reused, and the oldest ones if
+ * there are still too many.
+ */
+static void
+reportd_report_index_trim (ReportdReportIndex *self)
+{
+    GHashTableIter iter;
+    ReportdReportIndexEntry *entry;
+    gint64 now;
+    unsigned int n_reported = 0;
+
+    now = g_get_monotonic_time ();
+
+    g_hash_table_iter_init (&iter, self->entries);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+    {
+        if (reportd_report_index_entry_is_expired (entry, now))
+        {
+            g_hash_table_iter_remove (&iter);
+        }
+        else if (NULL != entry->reported_to)
+        {
+            n_reported++;
+        }
+    }
+
+    while (n_reported > REPORTD_REPORT_INDEX_MAX_REPORTED)
+    {
+        gpointer oldest_key = NULL;
+        gint64 oldest_at = G_MAXINT64;
+        gpointer key;
+
+        g_hash_table_iter_init (&iter, self->entries);
+        while (g_hash_table_iter_next (&iter, &key, (gpointer *) &entry))
+        {
+            if (NULL != entry->reported_to && entry->reported_at < oldest_at)
+            {
+                oldest_key = key;
+                oldest_at = entry->reported_at;
+            }
+        }
+
+        g_hash_table_remove (self->entries, oldest_key);
+
+        n_reported--;
+    }
+}
+
+/* Looks the problem up and, unless it has been reported already, either
+ * makes the caller responsible for reporting it, or queues the function to
+ * be called once whoever is responsible is done.
+ */
+ReportdReportIndexState
+reportd_report_index_claim (ReportdReportIndex      *self,
+                            const char              *uid,
+                            const char              *workflow,
+                            const char              *duphash,
+                            const char             **reported_to,
+                            ReportdReportIndexFunc   func,
+                            gpointer                 user_data)
+{
+    g_autofree char *key = NULL;
+    ReportdReportIndexEntry *entry;
+    ReportdReportIndexWaiter *waiter;
+
+    g_return_val_if_fail (REPORTD_IS_REPORT_INDEX (self), REPORTD_REPORT_INDEX_CLAIMED);
+    g_return_val_if_fail (NULL != reported_to, REPORTD_REPORT_INDEX_CLAIMED);
+
+    key = reportd_report_index_get_key (uid, workflow, duphash);
+    entry = g_hash_table_lookup (self->entries, key);
+    if (NULL != entry && reportd_report_index_entry_is_expired (entry, g_get_monotonic_time ()))
+    {
+        g_hash_table_remove (self->entries, key);
+
+        entry = NULL;
+    }
+    if (NULL == entry)
+    {
+        entry = g_new0 (ReportdReportIndexEntry, 1);
+
+        g_queue_init (&entry->waiters);
+
+        g_hash_table_insert (self->entries, g_steal_pointer (&key), entry);
+
+        return REPORTD_REPORT_INDEX_CLAIMED;
+    }
+
+    if (NULL != entry->reported_to)
+    {
+        *reported_to = entry->reported_to;
+
+        return REPORTD_REPORT_INDEX_REPORTED;
+    }
+
+    waiter = g_new0 (ReportdReportIndexWaiter, 1);
+
+    waiter->func = func;
+    waiter->user_data = user_data;
+
+    g_queue_push_tail (&entry->waiters, waiter);
+
+    return REPORTD_REPORT_INDEX_IN_FLIGHT;
+}
+
+/* Gives up a claim, recording the outcome of the report. After a success,
+ * all those waiting are told where the problem went. After a failure, only
+ * the first of them is told, and the claim passes on to it, the others
+ * carry on waiting.
+ */
+void
+reportd_report_index_release (ReportdReportIndex *self,
+                              const char         *uid,
+                              const char         *workflow,
+                              const char         *duphash,
+                              const char         *reported_to)
+{
+    g_autofree char *key = NULL;
+    g_autofree char *outcome = NULL;
+    ReportdReportIndexEntry *entry;
+    GQueue waiters;
+    ReportdReportIndexWaiter *waiter;
+
+    g_return_if_fail (REPORTD_IS_REPORT_INDEX (self));
+
+    key = reportd_report_index_get_key (uid, workflow, duphash);
+    entry = g_hash_table_lookup (self->entries, key);
+
+    g_return_if_fail (NULL != entry && NULL == entry->reported_to);
+
+    if (NULL == reported_to)
+    {
+        waiter = g_queue_pop_head (&entry->waiters);
+        if (NULL == waiter)
+        {
+            g_hash_table_remove (self->entries, key);
+
+            return;
+        }
+
+        waiter->func (NULL, waiter->user_data);
+
+        g_free (waiter);
+
+        return;
+    }
+
+    waiters = entry->waiters;
+    g_queue_init (&entry->waiters);
+    outcome = g_strdup (reported_to);
+
+    entry->reported_to = g_strdup (reported_to);
+    entry->reported_at = g_get_monotonic_time ();
+
+    reportd_report_index_trim (self);
+
+    while (NULL != (waiter = g_queue_pop_head (&waiters)))
+    {
+        waiter->func (outcome, waiter->user_data);
+
+        g_free (waiter);
+    }
+}
+
+void
+reportd_report_index_forget_waiter (ReportdReportIndex *self,
+                                    const char         *uid,
+                                    const char         *workflow,
+                                    const char         *duphash,
+                                    gpointer            user_data)
+{
+    g_autofree char *key = NULL;
+    ReportdReportIndexEntry *entry;
+
+    g_return_if_fail (REPORTD_IS_REPORT_INDEX (self));
+
+    key = reportd_report_index_get_key (uid, workflow, duphash);
+    entry = g_hash_table_lookup (self->entries, key);
+    if (NULL == entry)
+    {
+        return;
+    }
+
+    for (GList *l = entry->waiters.head; NULL != l; l = l->next)
+    {
+        ReportdReportIndexWaiter *waiter = l->data;
+
+        if (waiter->user_data == user_data)
+        {
+            g_queue_delete_link (&entry->waiters, l);
+            g_free (waiter);
+
+            return;
+        }
+    }
+}
+
+static void
+reportd_report_index_init (ReportdReportIndex *self)
+{
+    self->entries = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           g_free, (GDestroyNotify) reportd_report_index_entry_free);
+}
+
+static void
+reportd_report_index_finalize (GObject *object)
+{
+    ReportdReportIndex *self;
+
+    self = REPORTD_REPORT_INDEX (object);
+
+    g_clear_pointer (&self->entries, g_hash_table_destroy);
+
+    G_OBJECT_CLASS (reportd_report_index_parent_class)->finalize (object);
+}
+
+static void
+reportd_report_index_class_init (ReportdReportIndexClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    object_class->finalize = reportd_report_index_finalize;
+}
+
+ReportdReportIndex *
+reportd_report_index_new (void)
+{
+    return g_object_new (REPORTD_TYPE_REPORT_INDEX, NULL);
+}
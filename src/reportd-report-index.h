@@ -0,0 +1,67 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define REPORTD_TYPE_REPORT_INDEX reportd_report_index_get_type ()
+
+/* Where problems have been reported, keyed by the user they belong to, the
+ * workflow and the duphash, so that duplicates need not be reported all over
+ * again. Reports are only reused for a day. Only to be touched from the
+ * main thread.
+ */
+G_DECLARE_FINAL_TYPE (ReportdReportIndex, reportd_report_index, REPORTD, REPORT_INDEX, GObject)
+
+typedef enum
+{
+    /* Nobody has reported the problem, the caller is to do it */
+    REPORTD_REPORT_INDEX_CLAIMED,
+    /* Somebody is reporting the problem right now */
+    REPORTD_REPORT_INDEX_IN_FLIGHT,
+    /* The problem has been reported already */
+    REPORTD_REPORT_INDEX_REPORTED,
+} ReportdReportIndexState;
+
+/* Called once the report in flight is done, with the reported_to lines it
+ * produced, or NULL if it failed, in which case the claim has passed on to
+ * the one called.
+ */
+typedef void (*ReportdReportIndexFunc) (const char *reported_to,
+                                        gpointer    user_data);
+
+ReportdReportIndexState reportd_report_index_claim         (ReportdReportIndex     *index,
+                                                            const char             *uid,
+                                                            const char             *workflow,
+                                                            const char             *duphash,
+                                                            const char            **reported_to,
+                                                            ReportdReportIndexFunc  func,
+                                                            gpointer                user_data);
+void                    reportd_report_index_release       (ReportdReportIndex     *index,
+                                                            const char             *uid,
+                                                            const char             *workflow,
+                                                            const char             *duphash,
+                                                            const char             *reported_to);
+void                    reportd_report_index_forget_waiter (ReportdReportIndex     *index,
+                                                            const char             *uid,
+                                                            const char             *workflow,
+                                                            const char             *duphash,
+                                                            gpointer                user_data);
+
+ReportdReportIndex     *reportd_report_index_new           (void);
+
+G_END_DECLS
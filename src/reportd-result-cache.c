@@ -0,0 +1,540 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#include "reportd-result-cache.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <utime.h>
+
+#include <glib/gstdio.h>
+
+#include <problem_data.h>
+
+#define REPORTD_RESULT_CACHE_BUFFER_SIZE 65536
+/* Entries not used for this long are removed, as are the least recently
+ * used ones once all of them take up more than the size limit.
+ */
+#define REPORTD_RESULT_CACHE_MAX_AGE (7 * 24 * 60 * 60)
+#define REPORTD_RESULT_CACHE_MAX_SIZE (256 * 1024 * 1024)
+
+struct _ReportdResultCache
+{
+    GObject parent;
+
+    char *path;
+};
+
+G_DEFINE_TYPE (ReportdResultCache, reportd_result_cache, G_TYPE_OBJECT)
+
+enum
+{
+    PROP_0,
+    PROP_PATH,
+    N_PROPERTIES,
+};
+
+static GParamSpec *properties[N_PROPERTIES];
+
+/* SHA-256 of the contents of a file */
+static bool
+reportd_result_cache_digest_file (const char  *path,
+                                  guint8      *digest,
+                                  gsize       *digest_length,
+                                  GError     **error)
+{
+    g_autoptr (GFile) file = NULL;
+    g_autoptr (GFileInputStream) stream = NULL;
+    g_autoptr (GChecksum) checksum = NULL;
+    g_autofree guchar *buffer = NULL;
+    gssize size;
+
+    file = g_file_new_for_path (path);
+    stream = g_file_read (file, NULL, error);
+    if (NULL == stream)
+    {
+        return false;
+    }
+
+    checksum = g_checksum_new (G_CHECKSUM_SHA256);
+    buffer = g_malloc (REPORTD_RESULT_CACHE_BUFFER_SIZE);
+
+    while ((size = g_input_stream_read (G_INPUT_STREAM (stream), buffer,
+                                        REPORTD_RESULT_CACHE_BUFFER_SIZE, NULL, error)) > 0)
+    {
+        g_checksum_update (checksum, buffer, size);
+    }
+
+    if (0 != size)
+    {
+        return false;
+    }
+
+    g_checksum_get_digest (checksum, digest, digest_length);
+
+    return true;
+}
+
+static int
+reportd_result_cache_compare_strings (gconstpointer a,
+                                      gconstpointer b)
+{
+    return g_strcmp0 (*(const char * const *) a, *(const char * const *) b);
+}
+
+/* SHA-256 over the event name, the environment of its handlers and the
+ * contents of the elements it reads. Missing elements count as well, as
+ * their absence is just as much of an input.
+ *
+ * The owner of the problem always counts, whether the event reads it or
+ * not, so that results are never shared between users.
+ *
+ * Every string goes in NUL-terminated and none of them is empty, so an empty
+ * one ends the environment. Each element is followed by a tag telling a
+ * missing one from a present one, and then by the digest of its contents.
+ */
+char *
+reportd_result_cache_compute_key (const char          *event,
+                                  const char * const  *environment,
+                                  const char          *problem_directory,
+                                  const char * const  *reads,
+                                  GError             **error)
+{
+    g_autoptr (GChecksum) checksum = NULL;
+    g_autoptr (GPtrArray) sorted_reads = NULL;
+
+    g_return_val_if_fail (NULL != event, NULL);
+    g_return_val_if_fail (NULL != problem_directory, NULL);
+
+    checksum = g_checksum_new (G_CHECKSUM_SHA256);
+
+    g_checksum_update (checksum, (const guchar *) event, strlen (event) + 1);
+
+    for (; NULL != environment && NULL != *environment; environment++)
+    {
+        g_checksum_update (checksum, (const guchar *) *environment, strlen (*environment) + 1);
+    }
+
+    g_checksum_update (checksum, (const guchar *) "", 1);
+
+    sorted_reads = g_ptr_array_new ();
+
+    g_ptr_array_add (sorted_reads, (gpointer) FILENAME_UID);
+
+    for (; NULL != reads && NULL != *reads; reads++)
+    {
+        if (g_strcmp0 (*reads, FILENAME_UID) != 0)
+        {
+            g_ptr_array_add (sorted_reads, (gpointer) *reads);
+        }
+    }
+
+    g_ptr_array_sort (sorted_reads, reportd_result_cache_compare_strings);
+
+    for (unsigned int i = 0; i < sorted_reads->len; i++)
+    {
+        const char *element;
+        g_autofree char *path = NULL;
+        guint8 digest[32];
+        gsize digest_length = sizeof (digest);
+
+        element = g_ptr_array_index (sorted_reads, i);
+        path = g_build_filename (problem_directory, element, NULL);
+
+        g_checksum_update (checksum, (const guchar *) element, strlen (element) + 1);
+
+        if (!g_file_test (path, G_FILE_TEST_IS_REGULAR))
+        {
+            g_checksum_update (checksum, (const guchar *) "M", 1);
+
+            continue;
+        }
+
+        if (!reportd_result_cache_digest_file (path, digest, &digest_length, error))
+        {
+            return NULL;
+        }
+
+        g_checksum_update (checksum, (const guchar *) "F", 1);
+        g_checksum_update (checksum, digest, digest_length);
+    }
+
+    return g_strdup (g_checksum_get_string (checksum));
+}
+
+static bool
+reportd_result_cache_copy_file (const char  *source_path,
+                                const char  *destination_path,
+                                GError     **error)
+{
+    g_autoptr (GFile) source = NULL;
+    g_autoptr (GFile) destination = NULL;
+
+    source = g_file_new_for_path (source_path);
+    destination = g_file_new_for_path (destination_path);
+
+    return g_file_copy (source, destination,
+                        G_FILE_COPY_OVERWRITE | G_FILE_COPY_NOFOLLOW_SYMLINKS,
+                        NULL, NULL, NULL, error);
+}
+
+typedef struct
+{
+    char *path;
+    time_t used;
+    goffset size;
+} ReportdResultCacheEntry;
+
+static void
+reportd_result_cache_entry_free (ReportdResultCacheEntry *entry)
+{
+    g_free (entry->path);
+    g_free (entry);
+}
+
+static int
+reportd_result_cache_compare_entries (gconstpointer a,
+                                      gconstpointer b)
+{
+    const ReportdResultCacheEntry *entry_a = *(ReportdResultCacheEntry * const *) a;
+    const ReportdResultCacheEntry *entry_b = *(ReportdResultCacheEntry * const *) b;
+
+    return (entry_a->used > entry_b->used) - (entry_a->used < entry_b->used);
+}
+
+static goffset
+reportd_result_cache_get_entry_size (const char *path)
+{
+    g_autoptr (GDir) directory = NULL;
+    const char *name;
+    goffset size = 0;
+
+    directory = g_dir_open (path, 0, NULL);
+    if (NULL == directory)
+    {
+        return 0;
+    }
+
+    while (NULL != (name = g_dir_read_name (directory)))
+    {
+        g_autofree char *element_path = NULL;
+        GStatBuf buffer;
+
+        element_path = g_build_filename (path, name, NULL);
+
+        if (g_lstat (element_path, &buffer) == 0)
+        {
+            size += buffer.st_size;
+        }
+    }
+
+    return size;
+}
+
+static void
+reportd_result_cache_remove_entry (const char *path)
+{
+    g_autoptr (GDir) directory = NULL;
+    const char *name;
+
+    directory = g_dir_open (path, 0, NULL);
+    if (NULL != directory)
+    {
+        while (NULL != (name = g_dir_read_name (directory)))
+        {
+            g_autofree char *element_path = NULL;
+
+            element_path = g_build_filename (path, name, NULL);
+
+            g_unlink (element_path);
+        }
+    }
+
+    g_rmdir (path);
+}
+
+static void
+reportd_result_cache_trim (ReportdResultCache *self)
+{
+    g_autoptr (GDir) directory = NULL;
+    g_autoptr (GPtrArray) entries = NULL;
+    const char *name;
+    time_t now;
+    goffset total_size = 0;
+
+    directory = g_dir_open (self->path, 0, NULL);
+    if (NULL == directory)
+    {
+        return;
+    }
+
+    entries = g_ptr_array_new_with_free_func ((GDestroyNotify) reportd_result_cache_entry_free);
+    now = time (NULL);
+
+    while (NULL != (name = g_dir_read_name (directory)))
+    {
+        ReportdResultCacheEntry *entry;
+        g_autofree char *path = NULL;
+        GStatBuf buffer;
+
+        /* Entries being put together have a suffix after a dot. */
+        if (NULL != strchr (name, '.'))
+        {
+            continue;
+        }
+
+        path = g_build_filename (self->path, name, NULL);
+        if (g_lstat (path, &buffer) == -1 || !S_ISDIR (buffer.st_mode))
+        {
+            continue;
+        }
+
+        if (now - buffer.st_mtime > REPORTD_RESULT_CACHE_MAX_AGE)
+        {
+            reportd_result_cache_remove_entry (path);
+
+            continue;
+        }
+
+        entry = g_new0 (ReportdResultCacheEntry, 1);
+
+        entry->path = g_steal_pointer (&path);
+        entry->used = buffer.st_mtime;
+        entry->size = reportd_result_cache_get_entry_size (entry->path);
+
+        total_size += entry->size;
+
+        g_ptr_array_add (entries, entry);
+    }
+
+    g_ptr_array_sort (entries, reportd_result_cache_compare_entries);
+
+    for (unsigned int i = 0; i < entries->len && total_size > REPORTD_RESULT_CACHE_MAX_SIZE; i++)
+    {
+        ReportdResultCacheEntry *entry;
+
+        entry = g_ptr_array_index (entries, i);
+
+        reportd_result_cache_remove_entry (entry->path);
+
+        total_size -= entry->size;
+    }
+}
+
+/* Copies the elements stored under the key into the problem directory.
+ * Returns false without setting an error if there is nothing stored.
+ */
+bool
+reportd_result_cache_restore (ReportdResultCache  *self,
+                              const char          *key,
+                              const char          *problem_directory,
+                              GError             **error)
+{
+    g_autofree char *entry_path = NULL;
+    g_autoptr (GDir) directory = NULL;
+    g_autoptr (GError) tmp_error = NULL;
+    const char *name;
+
+    g_return_val_if_fail (REPORTD_IS_RESULT_CACHE (self), false);
+    g_return_val_if_fail (NULL != key, false);
+
+    entry_path = g_build_filename (self->path, key, NULL);
+    directory = g_dir_open (entry_path, 0, &tmp_error);
+    if (NULL == directory)
+    {
+        if (!g_error_matches (tmp_error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+        {
+            g_propagate_error (error, g_steal_pointer (&tmp_error));
+        }
+
+        return false;
+    }
+
+    while (NULL != (name = g_dir_read_name (directory)))
+    {
+        g_autofree char *source_path = NULL;
+        g_autofree char *destination_path = NULL;
+
+        source_path = g_build_filename (entry_path, name, NULL);
+        destination_path = g_build_filename (problem_directory, name, NULL);
+
+        if (!reportd_result_cache_copy_file (source_path, destination_path, error))
+        {
+            return false;
+        }
+    }
+
+    /* Marks the entry as recently used. */
+    utime (entry_path, NULL);
+
+    return true;
+}
+
+/* Entries are put together under a temporary name and renamed into place,
+ * so a restore never sees half of one.
+ */
+bool
+reportd_result_cache_store (ReportdResultCache  *self,
+                            const char          *key,
+                            const char          *problem_directory,
+                            const char * const  *elements,
+                            GError             **error)
+{
+    g_autofree char *entry_path = NULL;
+    g_autofree char *temporary_path = NULL;
+
+    g_return_val_if_fail (REPORTD_IS_RESULT_CACHE (self), false);
+    g_return_val_if_fail (NULL != key, false);
+
+    if (g_mkdir_with_parents (self->path, 0700) == -1)
+    {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                     "Failed to create “%s”: %s", self->path, g_strerror (errno));
+
+        return false;
+    }
+
+    entry_path = g_build_filename (self->path, key, NULL);
+    temporary_path = g_strdup_printf ("%s.XXXXXX", entry_path);
+
+    if (NULL == g_mkdtemp (temporary_path))
+    {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                     "Failed to create “%s”: %s", temporary_path, g_strerror (errno));
+
+        return false;
+    }
+
+    for (; NULL != elements && NULL != *elements; elements++)
+    {
+        g_autofree char *source_path = NULL;
+        g_autofree char *destination_path = NULL;
+
+        source_path = g_build_filename (problem_directory, *elements, NULL);
+        destination_path = g_build_filename (temporary_path, *elements, NULL);
+
+        if (!reportd_result_cache_copy_file (source_path, destination_path, error))
+        {
+            reportd_result_cache_remove_entry (temporary_path);
+
+            return false;
+        }
+    }
+
+    if (g_rename (temporary_path, entry_path) == -1)
+    {
+        /* Someone else got there first with the same result. */
+        reportd_result_cache_remove_entry (temporary_path);
+    }
+
+    reportd_result_cache_trim (self);
+
+    return true;
+}
+
+static void
+reportd_result_cache_init (ReportdResultCache *self)
+{
+}
+
+static void
+reportd_result_cache_set_property (GObject      *object,
+                                   unsigned int  property_id,
+                                   const GValue *value,
+                                   GParamSpec   *pspec)
+{
+    ReportdResultCache *self;
+
+    self = REPORTD_RESULT_CACHE (object);
+
+    switch (property_id)
+    {
+        case PROP_PATH:
+        {
+            self->path = g_value_dup_string (value);
+        }
+        break;
+
+        default:
+        {
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        }
+    }
+}
+
+static void
+reportd_result_cache_get_property (GObject      *object,
+                                   unsigned int  property_id,
+                                   GValue       *value,
+                                   GParamSpec   *pspec)
+{
+    ReportdResultCache *self;
+
+    self = REPORTD_RESULT_CACHE (object);
+
+    switch (property_id)
+    {
+        case PROP_PATH:
+        {
+            g_value_set_string (value, self->path);
+        }
+        break;
+
+        default:
+        {
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        }
+    }
+}
+
+static void
+reportd_result_cache_finalize (GObject *object)
+{
+    ReportdResultCache *self;
+
+    self = REPORTD_RESULT_CACHE (object);
+
+    g_clear_pointer (&self->path, g_free);
+
+    G_OBJECT_CLASS (reportd_result_cache_parent_class)->finalize (object);
+}
+
+static void
+reportd_result_cache_class_init (ReportdResultCacheClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    object_class->set_property = reportd_result_cache_set_property;
+    object_class->get_property = reportd_result_cache_get_property;
+    object_class->finalize = reportd_result_cache_finalize;
+
+    properties[PROP_PATH] = g_param_spec_string ("path", "Path",
+                                                 "Path to the directory holding the results",
+                                                 NULL,
+                                                 (G_PARAM_READWRITE |
+                                                  G_PARAM_CONSTRUCT_ONLY |
+                                                  G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_properties (object_class, N_PROPERTIES, properties);
+}
+
+ReportdResultCache *
+reportd_result_cache_new (const char *path)
+{
+    return g_object_new (REPORTD_TYPE_RESULT_CACHE,
+                         "path", path,
+                         NULL);
+}
@@ -0,0 +1,49 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define REPORTD_TYPE_RESULT_CACHE reportd_result_cache_get_type ()
+
+/* Elements produced by pure events, keyed by what went into them, so that
+ * running such an event again over the same inputs can be skipped. Safe to
+ * use from any thread.
+ */
+G_DECLARE_FINAL_TYPE (ReportdResultCache, reportd_result_cache, REPORTD, RESULT_CACHE, GObject)
+
+char               *reportd_result_cache_compute_key (const char          *event,
+                                                      const char * const  *environment,
+                                                      const char          *problem_directory,
+                                                      const char * const  *reads,
+                                                      GError             **error);
+
+bool                reportd_result_cache_restore     (ReportdResultCache  *cache,
+                                                      const char          *key,
+                                                      const char          *problem_directory,
+                                                      GError             **error);
+bool                reportd_result_cache_store       (ReportdResultCache  *cache,
+                                                      const char          *key,
+                                                      const char          *problem_directory,
+                                                      const char * const  *elements,
+                                                      GError             **error);
+
+ReportdResultCache *reportd_result_cache_new         (const char          *path);
+
+G_END_DECLS
@@ -0,0 +1,637 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#include "reportd-scheduler.h"
+
+/* Jobs queued by a single sender within a priority class. */
+typedef struct
+{
+    char *sender;
+    GQueue jobs;
+} ReportdSchedulerLane;
+
+typedef struct
+{
+    /* Lanes with queued jobs, in round-robin order */
+    GQueue lanes;
+    /* Sender → ReportdSchedulerLane */
+    GHashTable *lanes_by_sender;
+} ReportdSchedulerQueue;
+
+struct _ReportdSchedulerJob
+{
+    ReportdSchedulerPriority priority;
+    ReportdSchedulerLane *lane;
+    bool dispatched;
+    unsigned int position;
+
+    ReportdSchedulerDispatchFunc dispatch;
+    ReportdSchedulerPositionFunc position_changed;
+    gpointer user_data;
+};
+
+typedef struct _ReportdSchedulerWork ReportdSchedulerWork;
+
+/* Hands completed work over to the main thread. Workers push onto a stack
+ * without taking any locks, and the main loop takes all of it at once,
+ * instead of every completion attaching a source of its own.
+ */
+typedef struct
+{
+    GSource source;
+
+    GMainContext *context;
+    ReportdSchedulerWork *completed;
+} ReportdSchedulerSource;
+
+struct _ReportdSchedulerWork
+{
+    ReportdSchedulerWorkFunc work_func;
+    ReportdSchedulerDoneFunc done_func;
+    gpointer data;
+
+    /* Held until the work is pushed, as the scheduler does not wait for
+     * its workers when going away.
+     */
+    ReportdSchedulerSource *source;
+    /* Next in the stack of completed work */
+    ReportdSchedulerWork *next;
+};
+
+struct _ReportdScheduler
+{
+    GObject parent;
+
+    unsigned int workers;
+    unsigned int running;
+
+    ReportdSchedulerQueue queues[REPORTD_SCHEDULER_N_PRIORITIES];
+
+    GThreadPool *pool;
+    unsigned int dispatch_source_id;
+    ReportdSchedulerSource *completion_source;
+};
+
+G_DEFINE_TYPE (ReportdScheduler, reportd_scheduler, G_TYPE_OBJECT)
+
+enum
+{
+    PROP_0,
+    PROP_WORKERS,
+    N_PROPERTIES,
+};
+
+static GParamSpec *properties[N_PROPERTIES];
+
+static void
+reportd_scheduler_lane_free (ReportdSchedulerLane *lane)
+{
+    g_free (lane->sender);
+    g_queue_clear (&lane->jobs);
+    g_free (lane);
+}
+
+static ReportdSchedulerJob *
+reportd_scheduler_pop (ReportdScheduler *self)
+{
+    for (int i = 0; i < REPORTD_SCHEDULER_N_PRIORITIES; i++)
+    {
+        ReportdSchedulerQueue *queue = &self->queues[i];
+        ReportdSchedulerLane *lane;
+        ReportdSchedulerJob *job;
+
+        lane = g_queue_pop_head (&queue->lanes);
+        if (NULL == lane)
+        {
+            continue;
+        }
+
+        job = g_queue_pop_head (&lane->jobs);
+        job->lane = NULL;
+
+        if (g_queue_is_empty (&lane->jobs))
+        {
+            g_hash_table_remove (queue->lanes_by_sender, lane->sender);
+        }
+        else
+        {
+            /* Give the other senders a go before this one gets another slot. */
+            g_queue_push_tail (&queue->lanes, lane);
+        }
+
+        return job;
+    }
+
+    return NULL;
+}
+
+/* Positions follow the dispatch order: the highest priority class first and,
+ * within a class, one job from each sender in turn.
+ */
+static void
+reportd_scheduler_update_positions (ReportdScheduler *self)
+{
+    unsigned int position = 0;
+
+    for (int i = 0; i < REPORTD_SCHEDULER_N_PRIORITIES; i++)
+    {
+        ReportdSchedulerQueue *queue = &self->queues[i];
+        g_autofree GList **cursors = NULL;
+        unsigned int n_lanes;
+        bool more = true;
+
+        cursors = g_new0 (GList *, g_queue_get_length (&queue->lanes));
+        n_lanes = 0;
+
+        for (GList *l = queue->lanes.head; NULL != l; l = l->next)
+        {
+            ReportdSchedulerLane *lane = l->data;
+
+            cursors[n_lanes++] = lane->jobs.head;
+        }
+
+        while (more)
+        {
+            more = false;
+
+            for (unsigned int j = 0; j < n_lanes; j++)
+            {
+                ReportdSchedulerJob *job;
+
+                if (NULL == cursors[j])
+                {
+                    continue;
+                }
+
+                job = cursors[j]->data;
+                cursors[j] = cursors[j]->next;
+
+                more = true;
+                position++;
+
+                if (job->position != position)
+                {
+                    job->position = position;
+
+                    if (NULL != job->position_changed)
+                    {
+                        job->position_changed (job, position, job->user_data);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static gboolean
+reportd_scheduler_dispatch (gpointer user_data)
+{
+    ReportdScheduler *self;
+
+    self = REPORTD_SCHEDULER (user_data);
+
+    self->dispatch_source_id = 0;
+
+    while (self->running < self->workers)
+    {
+        ReportdSchedulerJob *job;
+
+        job = reportd_scheduler_pop (self);
+        if (NULL == job)
+        {
+            break;
+        }
+
+        job->dispatched = true;
+        job->position = 0;
+        self->running++;
+
+        job->dispatch (job, job->user_data);
+    }
+
+    reportd_scheduler_update_positions (self);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+reportd_scheduler_queue_dispatch (ReportdScheduler *self)
+{
+    if (0 != self->dispatch_source_id)
+    {
+        return;
+    }
+
+    self->dispatch_source_id = g_idle_add (reportd_scheduler_dispatch, self);
+}
+
+ReportdSchedulerJob *
+reportd_scheduler_queue (ReportdScheduler             *self,
+                         const char                   *sender,
+                         ReportdSchedulerPriority      priority,
+                         ReportdSchedulerDispatchFunc  dispatch,
+                         ReportdSchedulerPositionFunc  position_changed,
+                         gpointer                      user_data)
+{
+    ReportdSchedulerQueue *queue;
+    ReportdSchedulerLane *lane;
+    ReportdSchedulerJob *job;
+
+    g_return_val_if_fail (REPORTD_IS_SCHEDULER (self), NULL);
+    g_return_val_if_fail (priority < REPORTD_SCHEDULER_N_PRIORITIES, NULL);
+    g_return_val_if_fail (NULL != dispatch, NULL);
+
+    if (NULL == sender)
+    {
+        sender = "";
+    }
+
+    queue = &self->queues[priority];
+    lane = g_hash_table_lookup (queue->lanes_by_sender, sender);
+    if (NULL == lane)
+    {
+        lane = g_new0 (ReportdSchedulerLane, 1);
+
+        lane->sender = g_strdup (sender);
+        g_queue_init (&lane->jobs);
+
+        g_hash_table_insert (queue->lanes_by_sender, lane->sender, lane);
+        g_queue_push_tail (&queue->lanes, lane);
+    }
+
+    job = g_new0 (ReportdSchedulerJob, 1);
+
+    job->priority = priority;
+    job->lane = lane;
+    job->dispatch = dispatch;
+    job->position_changed = position_changed;
+    job->user_data = user_data;
+
+    g_queue_push_tail (&lane->jobs, job);
+
+    reportd_scheduler_queue_dispatch (self);
+
+    return job;
+}
+
+/* Releases the slot held by a dispatched job, or drops a job that is still
+ * queued. Returns true in the latter case, in which case the dispatch
+ * function will never be called.
+ */
+bool
+reportd_scheduler_job_done (ReportdScheduler    *self,
+                            ReportdSchedulerJob *job)
+{
+    bool was_queued;
+
+    g_return_val_if_fail (REPORTD_IS_SCHEDULER (self), false);
+    g_return_val_if_fail (NULL != job, false);
+
+    was_queued = !job->dispatched;
+
+    if (was_queued)
+    {
+        ReportdSchedulerQueue *queue = &self->queues[job->priority];
+        ReportdSchedulerLane *lane = job->lane;
+
+        g_queue_remove (&lane->jobs, job);
+
+        if (g_queue_is_empty (&lane->jobs))
+        {
+            g_queue_remove (&queue->lanes, lane);
+            g_hash_table_remove (queue->lanes_by_sender, lane->sender);
+        }
+    }
+    else
+    {
+        self->running--;
+    }
+
+    g_free (job);
+
+    reportd_scheduler_queue_dispatch (self);
+
+    return was_queued;
+}
+
+static gboolean
+reportd_scheduler_source_prepare (GSource *source,
+                                  int     *timeout)
+{
+    ReportdSchedulerSource *self = (ReportdSchedulerSource *) source;
+
+    *timeout = -1;
+
+    return NULL != g_atomic_pointer_get (&self->completed);
+}
+
+static gboolean
+reportd_scheduler_source_check (GSource *source)
+{
+    ReportdSchedulerSource *self = (ReportdSchedulerSource *) source;
+
+    return NULL != g_atomic_pointer_get (&self->completed);
+}
+
+static ReportdSchedulerWork *
+reportd_scheduler_source_take (ReportdSchedulerSource *self)
+{
+    ReportdSchedulerWork *completed;
+    ReportdSchedulerWork *reversed = NULL;
+
+    do
+    {
+        completed = g_atomic_pointer_get (&self->completed);
+    } while (!g_atomic_pointer_compare_and_exchange (&self->completed, completed, NULL));
+
+    /* Newest first on the stack, oldest first for the callers */
+    while (NULL != completed)
+    {
+        ReportdSchedulerWork *next = completed->next;
+
+        completed->next = reversed;
+        reversed = completed;
+        completed = next;
+    }
+
+    return reversed;
+}
+
+static gboolean
+reportd_scheduler_source_dispatch (GSource     *source,
+                                   GSourceFunc  callback,
+                                   gpointer     user_data)
+{
+    ReportdSchedulerWork *work;
+
+    work = reportd_scheduler_source_take ((ReportdSchedulerSource *) source);
+
+    while (NULL != work)
+    {
+        ReportdSchedulerWork *next = work->next;
+
+        work->done_func (work->data);
+
+        g_free (work);
+
+        work = next;
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+reportd_scheduler_source_finalize (GSource *source)
+{
+    ReportdSchedulerWork *work;
+
+    g_main_context_unref (((ReportdSchedulerSource *) source)->context);
+
+    /* Whatever has not been handed over by now is not going to be. */
+    work = reportd_scheduler_source_take ((ReportdSchedulerSource *) source);
+
+    while (NULL != work)
+    {
+        ReportdSchedulerWork *next = work->next;
+
+        g_free (work);
+
+        work = next;
+    }
+}
+
+static GSourceFuncs reportd_scheduler_source_funcs =
+{
+    .prepare = reportd_scheduler_source_prepare,
+    .check = reportd_scheduler_source_check,
+    .dispatch = reportd_scheduler_source_dispatch,
+    .finalize = reportd_scheduler_source_finalize,
+};
+
+static void
+reportd_scheduler_source_push (ReportdSchedulerSource *self,
+                               ReportdSchedulerWork   *work)
+{
+    ReportdSchedulerWork *completed;
+
+    do
+    {
+        completed = g_atomic_pointer_get (&self->completed);
+        work->next = completed;
+    } while (!g_atomic_pointer_compare_and_exchange (&self->completed, completed, work));
+
+    /* Otherwise the main loop has yet to take what is there, and will take
+     * this along with it.
+     */
+    if (NULL == completed)
+    {
+        g_main_context_wakeup (self->context);
+    }
+}
+
+static void
+reportd_scheduler_work (gpointer data,
+                        gpointer user_data)
+{
+    ReportdSchedulerWork *work;
+    ReportdSchedulerSource *source;
+
+    work = data;
+    source = work->source;
+
+    work->work_func (work->data);
+
+    /* The work belongs to the main thread once pushed. */
+    reportd_scheduler_source_push (source, work);
+
+    g_source_unref ((GSource *) source);
+}
+
+/* Runs the work function in the scheduler’s own pool, then the done function
+ * on the main thread, in a batch with whatever else has been completed in
+ * the meantime.
+ */
+void
+reportd_scheduler_run_in_thread (ReportdScheduler         *self,
+                                 ReportdSchedulerWorkFunc  work_func,
+                                 ReportdSchedulerDoneFunc  done_func,
+                                 gpointer                  data)
+{
+    ReportdSchedulerWork *work;
+
+    g_return_if_fail (REPORTD_IS_SCHEDULER (self));
+    g_return_if_fail (NULL != work_func);
+    g_return_if_fail (NULL != done_func);
+
+    work = g_new0 (ReportdSchedulerWork, 1);
+
+    work->work_func = work_func;
+    work->done_func = done_func;
+    work->data = data;
+    work->source = (ReportdSchedulerSource *) g_source_ref ((GSource *) self->completion_source);
+
+    g_thread_pool_push (self->pool, work, NULL);
+}
+
+static void
+reportd_scheduler_init (ReportdScheduler *self)
+{
+    for (int i = 0; i < REPORTD_SCHEDULER_N_PRIORITIES; i++)
+    {
+        g_queue_init (&self->queues[i].lanes);
+        self->queues[i].lanes_by_sender = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                                  NULL,
+                                                                  (GDestroyNotify) reportd_scheduler_lane_free);
+    }
+}
+
+static void
+reportd_scheduler_set_property (GObject      *object,
+                                unsigned int  property_id,
+                                const GValue *value,
+                                GParamSpec   *pspec)
+{
+    ReportdScheduler *self;
+
+    self = REPORTD_SCHEDULER (object);
+
+    switch (property_id)
+    {
+        case PROP_WORKERS:
+        {
+            self->workers = g_value_get_uint (value);
+        }
+        break;
+
+        default:
+        {
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        }
+    }
+}
+
+static void
+reportd_scheduler_get_property (GObject      *object,
+                                unsigned int  property_id,
+                                GValue       *value,
+                                GParamSpec   *pspec)
+{
+    ReportdScheduler *self;
+
+    self = REPORTD_SCHEDULER (object);
+
+    switch (property_id)
+    {
+        case PROP_WORKERS:
+        {
+            g_value_set_uint (value, self->workers);
+        }
+        break;
+
+        default:
+        {
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        }
+    }
+}
+
+static void
+reportd_scheduler_constructed (GObject *object)
+{
+    ReportdScheduler *self;
+    g_autoptr (GError) error = NULL;
+
+    self = REPORTD_SCHEDULER (object);
+
+    G_OBJECT_CLASS (reportd_scheduler_parent_class)->constructed (object);
+
+    self->completion_source = (ReportdSchedulerSource *) g_source_new (&reportd_scheduler_source_funcs,
+                                                                      sizeof (ReportdSchedulerSource));
+
+    self->completion_source->context = g_main_context_ref_thread_default ();
+
+    g_source_set_name ((GSource *) self->completion_source, "reportd scheduler completions");
+    g_source_attach ((GSource *) self->completion_source, self->completion_source->context);
+
+    self->pool = g_thread_pool_new (reportd_scheduler_work, self,
+                                    self->workers, TRUE, &error);
+    if (NULL == self->pool)
+    {
+        g_error ("Failed to start the worker threads: %s", error->message);
+    }
+}
+
+static void
+reportd_scheduler_finalize (GObject *object)
+{
+    ReportdScheduler *self;
+
+    self = REPORTD_SCHEDULER (object);
+
+    if (0 != self->dispatch_source_id)
+    {
+        g_source_remove (self->dispatch_source_id);
+    }
+
+    if (NULL != self->pool)
+    {
+        /* Prompts are answered on the main loop, so workers only ever wait
+         * on the disk or the bus and the queued work can be run to the end
+         * rather than dropped along with its data.
+         */
+        g_thread_pool_free (self->pool, FALSE, TRUE);
+    }
+
+    if (NULL != self->completion_source)
+    {
+        g_source_destroy ((GSource *) self->completion_source);
+        g_source_unref ((GSource *) self->completion_source);
+    }
+
+    for (int i = 0; i < REPORTD_SCHEDULER_N_PRIORITIES; i++)
+    {
+        g_queue_clear (&self->queues[i].lanes);
+        g_clear_pointer (&self->queues[i].lanes_by_sender, g_hash_table_destroy);
+    }
+
+    G_OBJECT_CLASS (reportd_scheduler_parent_class)->finalize (object);
+}
+
+static void
+reportd_scheduler_class_init (ReportdSchedulerClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    object_class->set_property = reportd_scheduler_set_property;
+    object_class->get_property = reportd_scheduler_get_property;
+    object_class->constructed = reportd_scheduler_constructed;
+    object_class->finalize = reportd_scheduler_finalize;
+
+    properties[PROP_WORKERS] = g_param_spec_uint ("workers", "Workers",
+                                                  "Maximum number of tasks running at once",
+                                                  1, G_MAXINT, 1,
+                                                  (G_PARAM_READWRITE |
+                                                   G_PARAM_CONSTRUCT_ONLY |
+                                                   G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_properties (object_class, N_PROPERTIES, properties);
+}
+
+ReportdScheduler *
+reportd_scheduler_new (unsigned int workers)
+{
+    return g_object_new (REPORTD_TYPE_SCHEDULER,
+                         "workers", workers,
+                         NULL);
+}
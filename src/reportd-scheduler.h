@@ -0,0 +1,70 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define REPORTD_TYPE_SCHEDULER reportd_scheduler_get_type ()
+
+G_DECLARE_FINAL_TYPE (ReportdScheduler, reportd_scheduler, REPORTD, SCHEDULER, GObject)
+
+/* Jobs of a higher priority class are always dispatched first. */
+typedef enum
+{
+    REPORTD_SCHEDULER_PRIORITY_INTERACTIVE,
+    REPORTD_SCHEDULER_PRIORITY_BULK,
+    REPORTD_SCHEDULER_N_PRIORITIES,
+} ReportdSchedulerPriority;
+
+typedef struct _ReportdSchedulerJob ReportdSchedulerJob;
+
+/* Called on the main thread once the job has been given a slot. The slot is
+ * held until reportd_scheduler_job_done() is called.
+ */
+typedef void (*ReportdSchedulerDispatchFunc) (ReportdSchedulerJob *job,
+                                              gpointer             user_data);
+/* Called on the main thread whenever the position of a queued job changes,
+ * positions start at 1.
+ */
+typedef void (*ReportdSchedulerPositionFunc) (ReportdSchedulerJob *job,
+                                              unsigned int         position,
+                                              gpointer             user_data);
+
+/* Called in a worker thread, leaving whatever it produces in the data */
+typedef void (*ReportdSchedulerWorkFunc) (gpointer data);
+/* Called on the main thread once the work function has returned */
+typedef void (*ReportdSchedulerDoneFunc) (gpointer data);
+
+ReportdSchedulerJob *reportd_scheduler_queue         (ReportdScheduler             *scheduler,
+                                                      const char                   *sender,
+                                                      ReportdSchedulerPriority      priority,
+                                                      ReportdSchedulerDispatchFunc  dispatch,
+                                                      ReportdSchedulerPositionFunc  position_changed,
+                                                      gpointer                      user_data);
+bool                 reportd_scheduler_job_done      (ReportdScheduler             *scheduler,
+                                                      ReportdSchedulerJob          *job);
+
+void                 reportd_scheduler_run_in_thread (ReportdScheduler             *scheduler,
+                                                      ReportdSchedulerWorkFunc      work_func,
+                                                      ReportdSchedulerDoneFunc      done_func,
+                                                      gpointer                      data);
+
+ReportdScheduler    *reportd_scheduler_new           (unsigned int                  workers);
+
+G_END_DECLS
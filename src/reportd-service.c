@@ -18,6 +18,9 @@
 #include <run_event.h>
 #include <workflow.h>
 
+/* How long finished tasks stay around for clients to inspect */
+#define REPORTD_SERVICE_FINISHED_TASK_TTL 300
+
 struct _ReportdService
 {
     GDBusObjectSkeleton parent;
@@ -25,9 +28,7 @@ struct _ReportdService
     ReportdDaemon *daemon;
 
     ReportdDbusService *service_iface;
-    GHashTable *workflows;
-    GDBusProxy *session_proxy;
-    GHashTable *tasks;
+    GHashTable *clients;
 };
 
 G_DEFINE_TYPE(ReportdService, reportd_service, G_TYPE_DBUS_OBJECT_SKELETON)
@@ -41,98 +42,283 @@ enum
 
 static GParamSpec *properties[N_PROPERTIES];
 
-static GDBusProxy *
-reportd_service_get_session_proxy (ReportdService  *self,
-                                   GError         **error)
+/* Clients that have created tasks, each with a single watch on its bus name */
+typedef struct
 {
-    g_autoptr (GDBusConnection) connection = NULL;
-    g_autoptr (GDBusProxy) proxy = NULL;
-    g_autoptr (GVariant) tuple = NULL;
-    const char *session_path;
+    ReportdService *service;
+    char *name;
+    unsigned int bus_name_watcher_id;
+    GPtrArray *tasks;
+} ReportdServiceClient;
 
-    if (NULL != self->session_proxy)
-    {
-        return self->session_proxy;
-    }
+typedef struct
+{
+    ReportdServiceClient *client;
+    GDBusObject *task;
+    unsigned long started_handler_id;
+    unsigned long finished_handler_id;
+    unsigned int reap_source_id;
+    /* Set between the task being started and finishing */
+    bool running;
+} ReportdServiceTask;
+
+static void
+reportd_service_task_free (ReportdServiceTask *task)
+{
+    ReportdDaemon *daemon;
+
+    daemon = task->client->service->daemon;
+
+    g_clear_handle_id (&task->reap_source_id, g_source_remove);
+    g_clear_signal_handler (&task->started_handler_id, task->task);
+    g_clear_signal_handler (&task->finished_handler_id, task->task);
+
+    reportd_daemon_unregister_object (daemon, task->task);
+
+    g_clear_object (&task->task);
 
-    reportd_daemon_get_bus_connections (self->daemon, &connection, NULL);
+    g_free (task);
+}
+
+static void
+reportd_service_client_free (ReportdServiceClient *client)
+{
+    g_clear_handle_id (&client->bus_name_watcher_id, g_bus_unwatch_name);
+    g_clear_pointer (&client->tasks, g_ptr_array_unref);
+    g_clear_pointer (&client->name, g_free);
+
+    g_free (client);
+}
+
+static void
+reportd_service_on_name_vanished (GDBusConnection *connection,
+                                  const char      *name,
+                                  gpointer         user_data)
+{
+    ReportdServiceClient *client;
 
-    g_return_val_if_fail (G_IS_DBUS_CONNECTION (connection), NULL);
+    client = user_data;
 
-    proxy = g_dbus_proxy_new_sync (connection,
-                                   G_DBUS_PROXY_FLAGS_NONE,
-                                   NULL,
-                                   "org.freedesktop.problems",
-                                   "/org/freedesktop/Problems2",
-                                   "org.freedesktop.Problems2",
-                                   NULL, error);
-    if (NULL == proxy)
+    g_message ("Client “%s” vanished, removing its tasks", name);
+
+    /* Nobody is left to answer the prompts of what is still running, which
+     * would then hold on to its worker for good.
+     */
+    for (unsigned int i = 0; i < client->tasks->len; i++)
     {
-        return NULL;
+        ReportdServiceTask *task;
+
+        task = g_ptr_array_index (client->tasks, i);
+        if (!task->running)
+        {
+            continue;
+        }
+
+        if (REPORTD_IS_TASK (task->task))
+        {
+            reportd_task_cancel (REPORTD_TASK (task->task));
+        }
+        else
+        {
+            reportd_batch_task_cancel (REPORTD_BATCH_TASK (task->task));
+        }
     }
-    tuple = g_dbus_proxy_call_sync (proxy, "GetSession", NULL,
-                                    G_DBUS_CALL_FLAGS_NONE,
-                                    -1, NULL, error);
-    if (NULL == tuple)
+
+    g_hash_table_remove (client->service->clients, client->name);
+}
+
+static gboolean
+reportd_service_reap_task (gpointer user_data)
+{
+    ReportdServiceTask *task;
+    ReportdServiceClient *client;
+
+    task = user_data;
+    client = task->client;
+    task->reap_source_id = 0;
+
+    g_message ("Removing finished task “%s”", g_dbus_object_get_object_path (task->task));
+
+    g_ptr_array_remove_fast (client->tasks, task);
+
+    if (0 == client->tasks->len)
     {
-        return NULL;
+        g_hash_table_remove (client->service->clients, client->name);
     }
 
-    g_variant_get_child (tuple, 0, "&o", &session_path);
+    return G_SOURCE_REMOVE;
+}
+
+/* Finished tasks can be started again, which keeps them around. */
+static void
+reportd_service_on_task_started (GObject  *object,
+                                 gpointer  user_data)
+{
+    ReportdServiceTask *task;
 
-    self->session_proxy = g_dbus_proxy_new_sync (connection,
-                                                 G_DBUS_PROXY_FLAGS_NONE,
-                                                 NULL,
-                                                 "org.freedesktop.problems",
-                                                 session_path,
-                                                 "org.freedesktop.Problems2.Session",
-                                                 NULL, error);
+    task = user_data;
+    task->running = true;
 
-    return self->session_proxy;
+    g_clear_handle_id (&task->reap_source_id, g_source_remove);
 }
 
 static void
-reportd_service_unexport_task (gpointer data,
-                               gpointer user_data)
+reportd_service_on_task_finished (GObject  *object,
+                                  gpointer  user_data)
 {
-    ReportdTask *task;
-    ReportdDaemon *daemon;
+    ReportdServiceTask *task;
 
-    task = REPORTD_TASK (data);
-    daemon = REPORTD_DAEMON (user_data);
+    task = user_data;
+    task->running = false;
 
-    reportd_daemon_unregister_object (daemon, G_DBUS_OBJECT (task));
+    g_clear_handle_id (&task->reap_source_id, g_source_remove);
+
+    task->reap_source_id = g_timeout_add_seconds (REPORTD_SERVICE_FINISHED_TASK_TTL,
+                                                  reportd_service_reap_task, task);
 }
 
-typedef struct
+/* Export the task and tie its lifetime to the client that asked for it. */
+static void
+reportd_service_export_task (ReportdService        *self,
+                             GDBusMethodInvocation *invocation,
+                             GDBusObjectSkeleton   *object)
 {
-    ReportdService *service;
-    unsigned int bus_name_watcher_id;
-} ReportdServiceBusNameWatcherData;
+    GDBusConnection *connection;
+    const char *sender;
+    ReportdServiceClient *client;
+    ReportdServiceTask *task;
 
-static void
-reportd_service_on_name_vanished (GDBusConnection *connection,
-                                  const char      *name,
-                                  gpointer         user_data)
+    connection = g_dbus_method_invocation_get_connection (invocation);
+    sender = g_dbus_method_invocation_get_sender (invocation);
+
+    reportd_daemon_register_object (self->daemon, connection, object);
+
+    client = g_hash_table_lookup (self->clients, sender);
+    if (NULL == client)
+    {
+        client = g_new0 (ReportdServiceClient, 1);
+
+        client->service = self;
+        client->name = g_strdup (sender);
+        client->tasks = g_ptr_array_new_with_free_func ((GDestroyNotify) reportd_service_task_free);
+        client->bus_name_watcher_id = g_bus_watch_name_on_connection (connection,
+                                                                      sender,
+                                                                      G_BUS_NAME_WATCHER_FLAGS_NONE,
+                                                                      NULL,
+                                                                      reportd_service_on_name_vanished,
+                                                                      client, NULL);
+
+        g_hash_table_insert (self->clients, client->name, client);
+    }
+
+    task = g_new0 (ReportdServiceTask, 1);
+
+    task->client = client;
+    task->task = g_object_ref (G_DBUS_OBJECT (object));
+    task->finished_handler_id = g_signal_connect (object, "finished",
+                                                  G_CALLBACK (reportd_service_on_task_finished),
+                                                  task);
+    task->started_handler_id = g_signal_connect (object, "started",
+                                                 G_CALLBACK (reportd_service_on_task_started),
+                                                 task);
+
+    g_ptr_array_add (client->tasks, task);
+}
+
+/* Sets up answers to questions the client knows about in advance, so that
+ * running the workflow needs no round trips to it.
+ */
+static bool
+reportd_service_apply_answer_options (ReportdTaskContext  *context,
+                                      GVariant            *options,
+                                      GError             **error)
+{
+    g_autoptr (GVariantIter) answers = NULL;
+    const char *unanswered;
+
+    if (g_variant_lookup (options, "answers", "a{ss}", &answers))
+    {
+        const char *pattern;
+        const char *answer;
+
+        while (g_variant_iter_next (answers, "{&s&s}", &pattern, &answer))
+        {
+            reportd_task_context_add_preset_answer (context, pattern, answer);
+        }
+    }
+
+    if (g_variant_lookup (options, "unanswered", "&s", &unanswered))
+    {
+        if (g_strcmp0 (unanswered, "ask") == 0)
+        {
+            reportd_task_context_set_unanswered (context, REPORTD_TASK_CONTEXT_UNANSWERED_ASK);
+        }
+        else if (g_strcmp0 (unanswered, "yes") == 0)
+        {
+            reportd_task_context_set_unanswered (context, REPORTD_TASK_CONTEXT_UNANSWERED_YES);
+        }
+        else if (g_strcmp0 (unanswered, "no") == 0)
+        {
+            reportd_task_context_set_unanswered (context, REPORTD_TASK_CONTEXT_UNANSWERED_NO);
+        }
+        else if (g_strcmp0 (unanswered, "fail") == 0)
+        {
+            reportd_task_context_set_unanswered (context, REPORTD_TASK_CONTEXT_UNANSWERED_FAIL);
+        }
+        else
+        {
+            g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                         "Unknown value of “unanswered”: “%s”", unanswered);
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Returns NULL after returning an error to the caller. */
+static ReportdTask *
+reportd_service_create_task (ReportdService        *self,
+                             GDBusMethodInvocation *invocation,
+                             const char            *workflow,
+                             const char            *problem,
+                             GVariant              *options)
 {
-    ReportdServiceBusNameWatcherData *data;
-    GPtrArray *task_array;
+    g_autoptr (ReportdWorkflowPlan) plan = NULL;
+    g_autoptr (ReportdTaskContext) context = NULL;
+    g_autoptr (GError) error = NULL;
+    ReportdTask *task;
 
-    data = user_data;
-    task_array = g_hash_table_lookup (data->service->tasks, name);
+    plan = reportd_daemon_get_workflow_plan (self->daemon, workflow);
+    if (NULL == plan)
+    {
+        g_dbus_method_invocation_return_error (invocation,
+                                               G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                                               "Creating task failed: unknown workflow “%s”",
+                                               workflow);
+        return NULL;
+    }
 
-    if (NULL != task_array)
+    context = reportd_task_context_new (plan, false);
+
+    if (NULL != options && !reportd_service_apply_answer_options (context, options, &error))
     {
-        g_ptr_array_foreach (task_array, reportd_service_unexport_task,
-                             data->service->daemon);
+        g_dbus_method_invocation_return_error (invocation, error->domain, error->code,
+                                               "Creating task failed: %s", error->message);
+        return NULL;
     }
 
-    g_hash_table_remove (data->service->tasks, name);
+    g_message ("Creating task for problem “%s”", problem);
 
-    g_clear_handle_id (&data->bus_name_watcher_id, g_bus_unwatch_name);
-    g_clear_object (&data->service);
+    task = reportd_task_new (self->daemon,
+                             g_dbus_method_invocation_get_connection (invocation),
+                             g_dbus_method_invocation_get_sender (invocation),
+                             REPORTD_DBUS_TASK_PATH, problem, context);
 
-    g_free (data);
+    reportd_service_export_task (self, invocation, G_DBUS_OBJECT_SKELETON (task));
+
+    return task;
 }
 
 static bool
@@ -143,52 +329,110 @@ reportd_service_handle_create_task (ReportdDbusService    *object,
                                     gpointer               user_data)
 {
     ReportdService *self;
-    workflow_t *workflow;
     g_autoptr (ReportdTask) task = NULL;
     const char *object_path;
-    g_autoptr (GDBusConnection) connection = NULL;
-    const char *sender;
-    ReportdServiceBusNameWatcherData *data;
-    GPtrArray *task_array;
 
     self = REPORTD_SERVICE (user_data);
-    workflow = g_hash_table_lookup (self->workflows, arg_workflow);
-    if (NULL == workflow)
+    task = reportd_service_create_task (self, invocation, arg_workflow, arg_problem, NULL);
+    if (NULL == task)
+    {
+        return true;
+    }
+
+    object_path = g_dbus_object_get_object_path (G_DBUS_OBJECT (task));
+
+    reportd_dbus_service_complete_create_task (object, invocation, object_path);
+
+    return true;
+}
+
+static bool
+reportd_service_handle_create_task_with_options (ReportdDbusService    *object,
+                                                 GDBusMethodInvocation *invocation,
+                                                 const char            *arg_workflow,
+                                                 const char            *arg_problem,
+                                                 GVariant              *arg_options,
+                                                 gpointer               user_data)
+{
+    ReportdService *self;
+    g_autoptr (ReportdTask) task = NULL;
+    const char *object_path;
+
+    self = REPORTD_SERVICE (user_data);
+    task = reportd_service_create_task (self, invocation, arg_workflow, arg_problem, arg_options);
+    if (NULL == task)
+    {
+        return true;
+    }
+
+    object_path = g_dbus_object_get_object_path (G_DBUS_OBJECT (task));
+
+    reportd_dbus_service_complete_create_task_with_options (object, invocation, object_path);
+
+    return true;
+}
+
+static bool
+reportd_service_handle_create_batch_task (ReportdDbusService    *object,
+                                          GDBusMethodInvocation *invocation,
+                                          const char            *arg_workflow,
+                                          const char * const    *arg_problems,
+                                          GVariant              *arg_options,
+                                          gpointer               user_data)
+{
+    ReportdService *self;
+    g_autoptr (ReportdWorkflowPlan) plan = NULL;
+    unsigned int max_parallel;
+    g_autoptr (ReportdTaskContext) context = NULL;
+    g_autoptr (GError) error = NULL;
+    g_autoptr (ReportdBatchTask) task = NULL;
+    const char *object_path;
+
+    self = REPORTD_SERVICE (user_data);
+    plan = reportd_daemon_get_workflow_plan (self->daemon, arg_workflow);
+    if (NULL == plan)
     {
         g_dbus_method_invocation_return_error (invocation,
                                                G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
-                                               "Creating task failed: unknown workflow “%s”",
+                                               "Creating batch task failed: unknown workflow “%s”",
                                                arg_workflow);
         return true;
     }
 
-    g_message ("Creating task for problem “%s”", arg_problem);
-
-    task = reportd_task_new (self->daemon, REPORTD_DBUS_TASK_PATH, arg_problem, workflow);
-    object_path = g_dbus_object_get_object_path (G_DBUS_OBJECT (task));
-    connection = g_dbus_method_invocation_get_connection (invocation);
-    sender = g_dbus_method_invocation_get_sender (invocation);
-    data = g_new0 (ReportdServiceBusNameWatcherData, 1);
-
-    data->service = g_object_ref (self);
-    data->bus_name_watcher_id = g_bus_watch_name_on_connection (connection,
-                                                                sender,
-                                                                G_BUS_NAME_WATCHER_FLAGS_NONE,
-                                                                NULL,
-                                                                reportd_service_on_name_vanished,
-                                                                data, NULL);
-
-    task_array = g_hash_table_lookup (self->tasks, sender);
-    if (NULL == task_array)
+    if (!g_variant_lookup (arg_options, "max-parallel", "u", &max_parallel))
+    {
+        max_parallel = g_get_num_processors ();
+    }
+    if (0 == max_parallel)
     {
-        task_array = g_ptr_array_new ();
+        g_dbus_method_invocation_return_error (invocation,
+                                               G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                                               "Creating batch task failed: “max-parallel” must not be 0");
+        return true;
+    }
+
+    context = reportd_task_context_new (plan, true);
 
-        g_hash_table_insert (self->tasks, g_strdup (sender), task_array);
+    if (!reportd_service_apply_answer_options (context, arg_options, &error))
+    {
+        g_dbus_method_invocation_return_error (invocation, error->domain, error->code,
+                                               "Creating batch task failed: %s", error->message);
+        return true;
     }
 
-    g_ptr_array_add (task_array, task);
+    g_message ("Creating batch task for %u problems", g_strv_length ((char **) arg_problems));
 
-    reportd_dbus_service_complete_create_task (object, invocation, object_path);
+    task = reportd_batch_task_new (self->daemon,
+                                   g_dbus_method_invocation_get_connection (invocation),
+                                   g_dbus_method_invocation_get_sender (invocation),
+                                   REPORTD_DBUS_BATCH_TASK_PATH,
+                                   arg_problems, context, max_parallel);
+
+    reportd_service_export_task (self, invocation, G_DBUS_OBJECT_SKELETON (task));
+
+    object_path = g_dbus_object_get_object_path (G_DBUS_OBJECT (task));
+
+    reportd_dbus_service_complete_create_batch_task (object, invocation, object_path);
 
     return true;
 }
@@ -207,6 +451,7 @@ reportd_service_handle_get_workflows (ReportdDbusService    *object,
 
     self = REPORTD_SERVICE (user_data);
     problem_directory = reportd_daemon_get_problem_directory (self->daemon,
+                                                              g_dbus_method_invocation_get_connection (invocation),
                                                               arg_problem,
                                                               &error);
     if (NULL == problem_directory)
@@ -227,7 +472,7 @@ reportd_service_handle_get_workflows (ReportdDbusService    *object,
         workflow_t *workflow;
 
         workflow_name = l->data;
-        workflow = g_hash_table_lookup (self->workflows, workflow_name);
+        workflow = reportd_daemon_get_workflow (self->daemon, workflow_name);
         if (NULL == workflow)
         {
             g_message ("Possible workflow without configuration: %s", workflow_name);
@@ -248,50 +493,43 @@ reportd_service_handle_get_workflows (ReportdDbusService    *object,
     return true;
 }
 
+static bool
+reportd_service_handle_get_metrics (ReportdDbusService    *object,
+                                    GDBusMethodInvocation *invocation,
+                                    gpointer               user_data)
+{
+    ReportdService *self;
+    ReportdMetrics *metrics;
+
+    self = REPORTD_SERVICE (user_data);
+    metrics = reportd_daemon_get_metrics (self->daemon);
+
+    reportd_dbus_service_complete_get_metrics (object, invocation,
+                                               reportd_metrics_serialize (metrics));
+
+    return true;
+}
+
 static void
-reportd_service_on_session_proxy_g_signal (GDBusProxy *proxy,
-                                           char       *sender_name,
-                                           char       *signal_name,
-                                           GVariant   *parameters,
-                                           gpointer    user_data)
+reportd_service_on_problems_session_authorized (GObject      *source_object,
+                                                GAsyncResult *res,
+                                                gpointer      user_data)
 {
+    ReportdProblemsSession *problems_session;
     GDBusMethodInvocation *invocation;
-    int status;
+    g_autoptr (GError) error = NULL;
 
+    problems_session = REPORTD_PROBLEMS_SESSION (source_object);
     invocation = G_DBUS_METHOD_INVOCATION (user_data);
 
-    if (g_strcmp0 (signal_name, "AuthorizationChanged") != 0)
+    if (!reportd_problems_session_authorize_finish (problems_session, res, &error))
     {
-        return;
-    }
-
-    g_variant_get_child (parameters, 0, "i", &status);
-
-    switch (status)
-    {
-        case 0:
-        {
-            g_dbus_method_invocation_return_value (invocation, NULL);
-        }
-        break;
-
-        case 1:
-        {
-            return;
-        }
-        break;
+        g_dbus_method_invocation_return_gerror (invocation, error);
 
-        default:
-        {
-            g_dbus_method_invocation_return_error (invocation,
-                                                   G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
-                                                   "Authorization has been lost or it failed");
-        }
+        return;
     }
 
-    g_signal_handlers_disconnect_by_func (proxy,
-                                          reportd_service_on_session_proxy_g_signal,
-                                          user_data);
+    g_dbus_method_invocation_return_value (invocation, NULL);
 }
 
 static bool
@@ -301,75 +539,15 @@ reportd_service_handle_authorize_problems_session (ReportdDbusService    *object
                                                    gpointer               user_data)
 {
     ReportdService *self;
-    GDBusProxy *session_proxy;
-    g_autoptr (GError) error = NULL;
-    g_autoptr (GVariant) tuple = NULL;
-    int result;
+    ReportdProblemsSession *problems_session;
 
     self = REPORTD_SERVICE (user_data);
-    session_proxy = reportd_service_get_session_proxy (self, &error);
-    if (NULL == session_proxy)
-    {
-        g_dbus_method_invocation_return_gerror (invocation, error);
-    }
-
-    g_signal_connect (session_proxy, "g-signal",
-                      G_CALLBACK (reportd_service_on_session_proxy_g_signal),
-                      invocation);
-
-    tuple = g_dbus_proxy_call_sync (session_proxy,
-                                    "Authorize",
-                                    g_variant_new ("(a{sv})", NULL),
-                                    G_DBUS_CALL_FLAGS_NONE, -1, NULL,
-                                    &error);
-    if (NULL == tuple)
-    {
-        g_dbus_method_invocation_return_gerror (invocation, error);
-
-        return true;
-    }
-
-    g_variant_get_child (tuple, 0, "i", &result);
-
-    switch (result)
-    {
-        case -1:
-        {
-            g_dbus_method_invocation_return_error (invocation,
-                                                   G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
-                                                   "Authorization failed");
-        }
-        break;
-
-        case 0:
-        {
-            reportd_dbus_service_complete_authorize_problems_session (object,
-                                                                      invocation);
-        }
-        break;
+    problems_session = reportd_daemon_get_problems_session (self->daemon,
+                                                            g_dbus_method_invocation_get_connection (invocation));
 
-        case 1:
-        {
-            return true;
-        }
-        break;
-
-        case 2:
-        {
-            g_dbus_method_invocation_return_error (invocation,
-                                                   G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
-                                                   "Authorization request already pending");
-        }
-        break;
-
-        default:
-        {
-        }
-    }
-
-    g_signal_handlers_disconnect_by_func (session_proxy,
-                                          reportd_service_on_session_proxy_g_signal,
-                                          invocation);
+    reportd_problems_session_authorize_async (problems_session, NULL,
+                                              reportd_service_on_problems_session_authorized,
+                                              invocation);
 
     return true;
 }
@@ -378,15 +556,29 @@ static void
 reportd_service_init (ReportdService *self)
 {
     self->service_iface = reportd_dbus_service_skeleton_new ();
-    self->workflows = libreport_load_workflow_config_data (NULL);
-    self->tasks = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                         g_free, (GDestroyNotify) g_ptr_array_unref);
+    self->clients = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           NULL, (GDestroyNotify) reportd_service_client_free);
 
     g_signal_connect (self->service_iface,
                       "handle-create-task",
                       G_CALLBACK (reportd_service_handle_create_task),
                       self);
 
+    g_signal_connect (self->service_iface,
+                      "handle-create-task-with-options",
+                      G_CALLBACK (reportd_service_handle_create_task_with_options),
+                      self);
+
+    g_signal_connect (self->service_iface,
+                      "handle-create-batch-task",
+                      G_CALLBACK (reportd_service_handle_create_batch_task),
+                      self);
+
+    g_signal_connect (self->service_iface,
+                      "handle-get-metrics",
+                      G_CALLBACK (reportd_service_handle_get_metrics),
+                      self);
+
     g_signal_connect (self->service_iface,
                       "handle-get-workflows",
                       G_CALLBACK (reportd_service_handle_get_workflows),
@@ -462,25 +654,13 @@ reportd_service_dispose (GObject *object)
 
     self = REPORTD_SERVICE (object);
 
+    g_clear_pointer (&self->clients, g_hash_table_destroy);
     g_clear_object (&self->daemon);
     g_clear_object (&self->service_iface);
-    g_clear_object (&self->session_proxy);
 
     G_OBJECT_CLASS (reportd_service_parent_class)->dispose (object);
 }
 
-static void
-reportd_service_finalize (GObject *object)
-{
-    ReportdService *self;
-
-    self = REPORTD_SERVICE (object);
-
-    g_clear_pointer (&self->workflows, g_hash_table_destroy);
-
-    G_OBJECT_CLASS (reportd_service_parent_class)->finalize (object);
-}
-
 static void
 reportd_service_class_init (ReportdServiceClass *klass)
 {
@@ -491,7 +671,6 @@ reportd_service_class_init (ReportdServiceClass *klass)
     object_class->set_property = reportd_service_set_property;
     object_class->get_property = reportd_service_get_property;
     object_class->dispose = reportd_service_dispose;
-    object_class->finalize = reportd_service_finalize;
 
     properties[PROP_DAEMON] = g_param_spec_object ("daemon", "Daemon",
                                                    "The owning daemon instance",
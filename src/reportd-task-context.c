@@ -0,0 +1,231 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#include "reportd-task-context.h"
+
+struct _ReportdTaskContext
+{
+    int ref_count;
+
+    ReportdWorkflowPlan *plan;
+
+    /* Answers given to prompts by any task using this context, keyed by
+     * prompt type and message. NULL if answers are not to be shared.
+     */
+    GHashTable *answers;
+    GMutex answers_mutex;
+
+    /* Answers given in advance by the client, in the order given. Set up
+     * before the context is handed to any task and left alone after.
+     */
+    GPtrArray *preset_answers;
+    ReportdTaskContextUnanswered unanswered;
+};
+
+typedef struct
+{
+    char *pattern;
+    char *answer;
+} ReportdTaskContextPresetAnswer;
+
+G_DEFINE_BOXED_TYPE (ReportdTaskContext, reportd_task_context,
+                     reportd_task_context_ref, reportd_task_context_unref)
+
+static char *
+reportd_task_context_get_answer_key (unsigned int  type,
+                                     const char   *message)
+{
+    return g_strdup_printf ("%u:%s", type, message);
+}
+
+static void
+reportd_task_context_preset_answer_free (ReportdTaskContextPresetAnswer *preset_answer)
+{
+    g_free (preset_answer->pattern);
+    g_free (preset_answer->answer);
+
+    g_free (preset_answer);
+}
+
+ReportdWorkflowPlan *
+reportd_task_context_get_plan (ReportdTaskContext *self)
+{
+    g_return_val_if_fail (NULL != self, NULL);
+
+    return self->plan;
+}
+
+char *
+reportd_task_context_lookup_answer (ReportdTaskContext *self,
+                                    unsigned int        type,
+                                    const char         *message)
+{
+    g_autofree char *key = NULL;
+    char *answer;
+
+    g_return_val_if_fail (NULL != self, NULL);
+
+    if (NULL == self->answers)
+    {
+        return NULL;
+    }
+
+    key = reportd_task_context_get_answer_key (type, message);
+
+    g_mutex_lock (&self->answers_mutex);
+    answer = g_strdup (g_hash_table_lookup (self->answers, key));
+    g_mutex_unlock (&self->answers_mutex);
+
+    return answer;
+}
+
+void
+reportd_task_context_store_answer (ReportdTaskContext *self,
+                                   unsigned int        type,
+                                   const char         *message,
+                                   const char         *answer)
+{
+    char *key;
+
+    g_return_if_fail (NULL != self);
+
+    if (NULL == self->answers || NULL == answer)
+    {
+        return;
+    }
+
+    key = reportd_task_context_get_answer_key (type, message);
+
+    g_mutex_lock (&self->answers_mutex);
+    g_hash_table_replace (self->answers, key, g_strdup (answer));
+    g_mutex_unlock (&self->answers_mutex);
+}
+
+void
+reportd_task_context_add_preset_answer (ReportdTaskContext *self,
+                                        const char         *pattern,
+                                        const char         *answer)
+{
+    ReportdTaskContextPresetAnswer *preset_answer;
+
+    g_return_if_fail (NULL != self);
+    g_return_if_fail (NULL != pattern);
+    g_return_if_fail (NULL != answer);
+
+    preset_answer = g_new0 (ReportdTaskContextPresetAnswer, 1);
+
+    preset_answer->pattern = g_strdup (pattern);
+    preset_answer->answer = g_strdup (answer);
+
+    g_ptr_array_add (self->preset_answers, preset_answer);
+}
+
+/* A preset answer applies if its pattern is the key of the user setting the
+ * question is about, or if it matches the message as a glob. The first one
+ * to apply wins.
+ */
+const char *
+reportd_task_context_lookup_preset_answer (ReportdTaskContext *self,
+                                           const char         *key,
+                                           const char         *message)
+{
+    g_return_val_if_fail (NULL != self, NULL);
+
+    for (unsigned int i = 0; i < self->preset_answers->len; i++)
+    {
+        ReportdTaskContextPresetAnswer *preset_answer;
+
+        preset_answer = g_ptr_array_index (self->preset_answers, i);
+
+        if (g_strcmp0 (preset_answer->pattern, key) == 0 ||
+            g_pattern_match_simple (preset_answer->pattern, message))
+        {
+            return preset_answer->answer;
+        }
+    }
+
+    return NULL;
+}
+
+ReportdTaskContextUnanswered
+reportd_task_context_get_unanswered (ReportdTaskContext *self)
+{
+    g_return_val_if_fail (NULL != self, REPORTD_TASK_CONTEXT_UNANSWERED_ASK);
+
+    return self->unanswered;
+}
+
+void
+reportd_task_context_set_unanswered (ReportdTaskContext           *self,
+                                     ReportdTaskContextUnanswered  unanswered)
+{
+    g_return_if_fail (NULL != self);
+
+    self->unanswered = unanswered;
+}
+
+ReportdTaskContext *
+reportd_task_context_ref (ReportdTaskContext *self)
+{
+    g_return_val_if_fail (NULL != self, NULL);
+
+    g_atomic_int_inc (&self->ref_count);
+
+    return self;
+}
+
+void
+reportd_task_context_unref (ReportdTaskContext *self)
+{
+    g_return_if_fail (NULL != self);
+
+    if (!g_atomic_int_dec_and_test (&self->ref_count))
+    {
+        return;
+    }
+
+    g_clear_pointer (&self->answers, g_hash_table_destroy);
+    g_clear_pointer (&self->preset_answers, g_ptr_array_unref);
+    g_mutex_clear (&self->answers_mutex);
+    reportd_workflow_plan_unref (self->plan);
+
+    g_free (self);
+}
+
+ReportdTaskContext *
+reportd_task_context_new (ReportdWorkflowPlan *plan,
+                          bool                 share_answers)
+{
+    ReportdTaskContext *self;
+
+    g_return_val_if_fail (NULL != plan, NULL);
+
+    self = g_new0 (ReportdTaskContext, 1);
+
+    self->ref_count = 1;
+    self->plan = reportd_workflow_plan_ref (plan);
+
+    if (share_answers)
+    {
+        self->answers = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                               g_free, g_free);
+    }
+
+    g_mutex_init (&self->answers_mutex);
+
+    self->preset_answers = g_ptr_array_new_with_free_func ((GDestroyNotify) reportd_task_context_preset_answer_free);
+    self->unanswered = REPORTD_TASK_CONTEXT_UNANSWERED_ASK;
+
+    return self;
+}
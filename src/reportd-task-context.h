@@ -0,0 +1,76 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#pragma once
+
+#include "reportd-workflow-plan.h"
+
+#include <stdbool.h>
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define REPORTD_TYPE_TASK_CONTEXT reportd_task_context_get_type ()
+
+/* Per-workflow state that can be shared by any number of tasks, so that
+ * running the same workflow over many problems only pays for the setup once.
+ */
+typedef struct _ReportdTaskContext ReportdTaskContext;
+
+/* What to do about questions nobody has given an answer to in advance */
+typedef enum
+{
+    /* Put them to the client */
+    REPORTD_TASK_CONTEXT_UNANSWERED_ASK,
+    /* Say yes, or give an empty answer if it is not a yes-or-no question */
+    REPORTD_TASK_CONTEXT_UNANSWERED_YES,
+    /* Say no, or give an empty answer if it is not a yes-or-no question */
+    REPORTD_TASK_CONTEXT_UNANSWERED_NO,
+    /* Fail the event asking */
+    REPORTD_TASK_CONTEXT_UNANSWERED_FAIL,
+} ReportdTaskContextUnanswered;
+
+GType               reportd_task_context_get_type                 (void);
+
+ReportdWorkflowPlan *reportd_task_context_get_plan                (ReportdTaskContext *context);
+
+char               *reportd_task_context_lookup_answer            (ReportdTaskContext *context,
+                                                                   unsigned int        type,
+                                                                   const char         *message);
+void                reportd_task_context_store_answer             (ReportdTaskContext *context,
+                                                                   unsigned int        type,
+                                                                   const char         *message,
+                                                                   const char         *answer);
+
+void                reportd_task_context_add_preset_answer        (ReportdTaskContext *context,
+                                                                   const char         *pattern,
+                                                                   const char         *answer);
+const char         *reportd_task_context_lookup_preset_answer     (ReportdTaskContext *context,
+                                                                   const char         *key,
+                                                                   const char         *message);
+
+ReportdTaskContextUnanswered reportd_task_context_get_unanswered  (ReportdTaskContext           *context);
+void                reportd_task_context_set_unanswered           (ReportdTaskContext           *context,
+                                                                   ReportdTaskContextUnanswered  unanswered);
+
+ReportdTaskContext *reportd_task_context_ref                      (ReportdTaskContext *context);
+void                reportd_task_context_unref                    (ReportdTaskContext *context);
+
+ReportdTaskContext *reportd_task_context_new                      (ReportdWorkflowPlan *plan,
+                                                                   bool                share_answers);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (ReportdTaskContext, reportd_task_context_unref)
+
+G_END_DECLS
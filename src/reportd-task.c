@@ -15,37 +15,173 @@
 #include "reportd.h"
 
 #include "reportd-dbus-generated.h"
+#include "reportd-journal.h"
 
 #include <client.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <gio/gunixfdlist.h>
+#include <glib-unix.h>
+#include <glib/gstdio.h>
 #include <internal_libreport.h>
 #include <run_event.h>
 #include <signal.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include <workflow.h>
 
+/* How long a canceled event handler gets to clean up before it is killed */
+#define REPORTD_TASK_KILL_TIMEOUT 5
+/* How much of the progress the log keeps before the rest is dropped */
+#define REPORTD_TASK_LOG_MAX_SIZE (16 * 1024 * 1024)
+#define REPORTD_TASK_LOG_TRUNCATED "[log truncated]\n"
+
+typedef enum
+{
+    ASK,
+    ASK_YES_NO,
+    ASK_YES_NO_YESFOREVER,
+    ASK_YES_NO_SAVE,
+    ASK_PASSWORD,
+} PromptType;
+
 typedef enum
 {
-    REPORTD_TASK_STATE_READY,
-    REPORTD_TASK_STATE_RUNNING,
-    REPORTD_TASK_STATE_COMPLETED,
-    REPORTD_TASK_STATE_FAILED,
-    REPORTD_TASK_STATE_CANCELED,
-} ReportdTaskState;
+    EVENT_WAITING,
+    EVENT_RUNNING,
+    EVENT_DONE,
+} EventState;
+
+typedef struct _ReportdTaskEvent ReportdTaskEvent;
 
 struct _ReportdTask
 {
     GDBusObjectSkeleton parent;
 
     ReportdDaemon *daemon;
+    GDBusConnection *connection;
+    /* Unique bus name of the client that created the task */
+    char *owner;
 
     ReportdDbusTask *task_iface;
     gchar *problem_path;
-    workflow_t *workflow;
-    struct run_event_state *run_state;
+    ReportdTaskContext *context;
 
+    ReportdSchedulerPriority priority;
+    ReportdSchedulerJob *job;
     GCancellable *cancellable;
 
-    GCond prompt_cond;
-    GMutex prompt_mutex;
+    /* Progress lines waiting to go out in a single ProgressBatch signal, NULL
+     * if the client wants a Progress signal for every line.
+     */
+    GPtrArray *progress_batch;
+    unsigned int progress_interval;
+    unsigned int progress_lines;
+    unsigned int progress_source_id;
+
+    /* Unique bus name → name watcher ID, for clients other than the owner
+     * that want to receive the signals of the task.
+     */
+    GHashTable *subscribers;
+
+    /* Everything reported as progress since the task was started, for
+     * clients to read at their own pace, up to REPORTD_TASK_LOG_MAX_SIZE.
+     */
+    int log_fd;
+    size_t log_size;
+
+    /* Exported the first time a question is put to the client and reused for
+     * the ones that follow, NULL until then.
+     */
+    GDBusObjectSkeleton *prompt_skeleton;
+    ReportdDbusTaskPrompt *prompt_iface;
+
+    /* Everything below is only touched from the main thread while the task
+     * is running.
+     */
+    GTask *run_task;
+    char *problem_directory;
+    ReportdJournal *journal;
+    /* Answers to text prompts given before the daemon went away mid-run */
+    GHashTable *resumed_answers;
+    /* Set if the problem has one, for finding out about duplicates, along
+     * with the user the problem belongs to
+     */
+    char *duphash;
+    char *uid;
+    /* The task is reporting the problem on behalf of its duplicates */
+    bool reporting;
+    char *reported_to;
+    /* Another task is reporting a duplicate of the problem */
+    bool waiting_for_report;
+    /* ReportdTaskEvent, in workflow order */
+    GPtrArray *events;
+    unsigned int running_events;
+    /* The first event in workflow order that failed, if any */
+    ReportdTaskEvent *failed_event;
+    GError *error;
+    /* Running the events has taken longer than the workflow allows */
+    bool timed_out;
+    unsigned int deadline_source_id;
+    /* The event whose question the client is being asked, and those waiting
+     * for their turn, as only one question is asked at a time.
+     */
+    ReportdTaskEvent *prompting_event;
+    GQueue prompt_queue;
+};
+
+/* A single event of the workflow being run by a task. Events run as soon as
+ * all the events they depend on are done.
+ */
+struct _ReportdTaskEvent
+{
+    ReportdTask *task;
+    const char *name;
+    unsigned int index;
+    EventState state;
+
+    /* Number of events that have yet to finish before this one can start */
+    unsigned int blockers;
+
+    struct run_event_state *run_state;
+    /* Element name → modification stamp, taken when the event started */
+    GHashTable *elements;
+    /* Where the results of a pure event go, and whether they came from there */
+    char *results_key;
+    bool cached;
+
+    /* Output of the running command not yet handled */
+    GString *output;
+    bool output_done;
+    unsigned int output_source_id;
+    bool child_exited;
+    int wait_status;
+    /* Falls back to a child watch if pidfds are not supported */
+    int pidfd;
+    unsigned int pidfd_source_id;
+    unsigned int child_watch_id;
+    unsigned int kill_source_id;
+    /* The handlers have taken longer than the event allows */
+    bool timed_out;
+    unsigned int deadline_source_id;
+
+    /* Run in-process by the executor of a plugin instead of by commands */
+    bool native;
+    GCancellable *native_cancellable;
+
+    /* The question nobody was there to answer, failing the event */
+    char *unanswered;
+
+    /* The question the running command is waiting on an answer to */
+    bool prompting;
+    PromptType prompt_type;
+    char *prompt_key;
+    char *prompt_message;
 };
 
 G_DEFINE_QUARK (reportd-task-error-quark, reportd_task_error)
@@ -55,478 +191,2777 @@ enum
 {
     PROP_0,
     PROP_DAEMON,
+    PROP_CONNECTION,
+    PROP_OWNER,
     PROP_PROBLEM_PATH,
-    PROP_WORKFLOW,
+    PROP_CONTEXT,
     N_PROPERTIES,
 };
 
-typedef enum
+enum
 {
-    ASK,
-    ASK_YES_NO,
-    ASK_YES_NO_YESFOREVER,
-    ASK_YES_NO_SAVE,
-    ASK_PASSWORD,
-} PromptType;
+    STARTED,
+    FINISHED,
+    N_SIGNALS,
+};
 
 static GParamSpec *properties[N_PROPERTIES];
+static unsigned int signals[N_SIGNALS];
 
 /*** Event running ***/
 
+/* Sends a signal of an exported interface to the owner of the object and
+ * its subscribers only, where the skeleton would broadcast it. Returns false
+ * if the interface is not exported, for the caller to emit the signal
+ * in-process instead.
+ */
+bool
+reportd_task_send_signal_to_watchers (GDBusInterfaceSkeleton *skeleton,
+                                      const char             *owner,
+                                      GHashTable             *subscribers,
+                                      const char             *signal_name,
+                                      GVariant               *parameters)
+{
+    GDBusConnection *connection;
+    const char *object_path;
+    const char *interface_name;
+    GHashTableIter iter;
+    gpointer subscriber;
+    g_autoptr (GError) error = NULL;
+
+    connection = g_dbus_interface_skeleton_get_connection (skeleton);
+    if (NULL == connection)
+    {
+        g_variant_unref (g_variant_ref_sink (parameters));
+
+        return false;
+    }
+
+    object_path = g_dbus_interface_skeleton_get_object_path (skeleton);
+    interface_name = g_dbus_interface_skeleton_get_info (skeleton)->name;
+
+    g_variant_ref_sink (parameters);
+
+    if (!g_dbus_connection_emit_signal (connection, owner, object_path,
+                                        interface_name, signal_name,
+                                        parameters, &error))
+    {
+        g_warning ("Failed to send %s signal: %s", signal_name, error->message);
+    }
+
+    g_hash_table_iter_init (&iter, subscribers);
+
+    /* No owner means the signal has been broadcast already. */
+    while (NULL != owner && g_hash_table_iter_next (&iter, &subscriber, NULL))
+    {
+        g_clear_error (&error);
+
+        if (g_strcmp0 (subscriber, owner) == 0)
+        {
+            continue;
+        }
+
+        if (!g_dbus_connection_emit_signal (connection, subscriber, object_path,
+                                            interface_name, signal_name,
+                                            parameters, &error))
+        {
+            g_warning ("Failed to send %s signal: %s", signal_name, error->message);
+        }
+    }
+
+    g_variant_unref (parameters);
+
+    return true;
+}
+
+/* Tasks that are not exported, like the items of batch tasks, emit their
+ * signals in-process.
+ */
+static bool
+reportd_task_send_signal (ReportdTask *self,
+                          const char  *signal_name,
+                          GVariant    *parameters)
+{
+    return reportd_task_send_signal_to_watchers (G_DBUS_INTERFACE_SKELETON (self->task_iface),
+                                                 self->owner, self->subscribers,
+                                                 signal_name, parameters);
+}
+
+static void
+reportd_task_flush_progress (ReportdTask *self)
+{
+    g_clear_handle_id (&self->progress_source_id, g_source_remove);
+
+    if (NULL == self->progress_batch || 0 == self->progress_batch->len)
+    {
+        return;
+    }
+
+    g_ptr_array_add (self->progress_batch, NULL);
+
+    if (!reportd_task_send_signal (self, "ProgressBatch",
+                                   g_variant_new ("(^as)", self->progress_batch->pdata)))
+    {
+        reportd_dbus_task_emit_progress_batch (self->task_iface,
+                                               (const char * const *) self->progress_batch->pdata);
+    }
+
+    g_ptr_array_set_size (self->progress_batch, 0);
+}
+
+static gboolean
+reportd_task_on_progress_timeout (gpointer user_data)
+{
+    ReportdTask *self;
+
+    self = REPORTD_TASK (user_data);
+
+    self->progress_source_id = 0;
+
+    reportd_task_flush_progress (self);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+reportd_task_log (ReportdTask *self,
+                  const char  *line)
+{
+    g_autofree char *buffer = NULL;
+    size_t length;
+    bool truncated = false;
+
+    if (-1 == self->log_fd)
+    {
+        return;
+    }
+
+    if (self->log_size >= REPORTD_TASK_LOG_MAX_SIZE)
+    {
+        return;
+    }
+
+    buffer = g_strconcat (line, "\n", NULL);
+    length = strlen (buffer);
+
+    /* A chatty handler must not be able to grow the daemon without bound,
+     * so room is kept for a note that the rest was dropped, after which the
+     * log is sealed against growing.
+     */
+    if (self->log_size + length + strlen (REPORTD_TASK_LOG_TRUNCATED) > REPORTD_TASK_LOG_MAX_SIZE)
+    {
+        g_free (buffer);
+        buffer = g_strdup (REPORTD_TASK_LOG_TRUNCATED);
+        length = strlen (buffer);
+        truncated = true;
+    }
+
+    if (libreport_full_write (self->log_fd, buffer, length) != (ssize_t) length)
+    {
+        g_warning ("Failed to write to the log of task “%s”: %s",
+                   self->problem_path, g_strerror (errno));
+    }
+
+    self->log_size += length;
+
+    if (truncated)
+    {
+        self->log_size = REPORTD_TASK_LOG_MAX_SIZE;
+
+        fcntl (self->log_fd, F_ADD_SEALS, F_SEAL_GROW);
+    }
+}
+
+static void
+reportd_task_emit_progress (ReportdTask *self,
+                            const char  *line)
+{
+    reportd_task_log (self, line);
+
+    if (NULL == self->progress_batch)
+    {
+        if (!reportd_task_send_signal (self, "Progress", g_variant_new ("(s)", line)))
+        {
+            reportd_dbus_task_emit_progress (self->task_iface, line);
+        }
+
+        return;
+    }
+
+    g_ptr_array_add (self->progress_batch, g_strdup (line));
+
+    if (0 != self->progress_lines && self->progress_batch->len >= self->progress_lines)
+    {
+        reportd_task_flush_progress (self);
+    }
+    else if (0 == self->progress_source_id && 0 != self->progress_interval)
+    {
+        self->progress_source_id = g_timeout_add (self->progress_interval,
+                                                  reportd_task_on_progress_timeout, self);
+    }
+}
+
 static char *
 do_log2 (char *log_line,
          void *param)
 {
     ReportdTask *self;
 
-    self = REPORTD_TASK (param);
+    self = REPORTD_TASK (param);
+
+    reportd_task_emit_progress (self, log_line);
+
+    return log_line;
+}
+
+static void
+reportd_task_error_callback (const char *error_line,
+                             void       *param)
+{
+    ReportdTask *self;
+
+    self = REPORTD_TASK (param);
+
+    reportd_task_emit_progress (self, error_line);
+}
+
+/* The event configuration goes into the environment of the spawned commands
+ * only, never into that of the daemon, which is shared by all the tasks
+ * running at the same time.
+ */
+static void
+reportd_task_event_set_environment (ReportdTaskEvent *event)
+{
+    ReportdWorkflowPlan *plan;
+    const char * const *environment;
+
+    plan = reportd_task_context_get_plan (event->task->context);
+    environment = reportd_workflow_plan_get_event_environment (plan, event->index);
+
+    g_ptr_array_set_size (event->run_state->extra_environment, 0);
+
+    for (; NULL != *environment; environment++)
+    {
+        g_ptr_array_add (event->run_state->extra_environment, g_strdup (*environment));
+    }
+}
+
+bool
+reportd_task_authorize_caller (GDBusMethodInvocation *invocation,
+                               const char            *owner)
+{
+    const char *sender;
+
+    sender = g_dbus_method_invocation_get_sender (invocation);
+
+    if (NULL == owner || g_strcmp0 (sender, owner) == 0)
+    {
+        return true;
+    }
+
+    g_dbus_method_invocation_return_error (invocation,
+                                           G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED,
+                                           "The task belongs to another client");
+
+    return false;
+}
+
+static gboolean
+reportd_task_on_authorize_method (GDBusInterfaceSkeleton *interface,
+                                  GDBusMethodInvocation  *invocation,
+                                  gpointer                user_data)
+{
+    ReportdTask *self;
+
+    self = REPORTD_TASK (user_data);
+
+    /* Anyone may watch a task, everything else is up to its owner. */
+    if (G_DBUS_INTERFACE_SKELETON (self->task_iface) == interface)
+    {
+        const char *method_name;
+
+        method_name = g_dbus_method_invocation_get_method_name (invocation);
+
+        if (g_strcmp0 (method_name, "Subscribe") == 0 ||
+            g_strcmp0 (method_name, "Unsubscribe") == 0)
+        {
+            return true;
+        }
+    }
+
+    return reportd_task_authorize_caller (invocation, self->owner);
+}
+
+static void reportd_task_event_process_output (ReportdTaskEvent *event);
+
+/* Sends the answer to a question asked by the running command. */
+static void
+reportd_task_event_answer (ReportdTaskEvent *event,
+                           const char       *answer)
+{
+    g_autofree char *line = NULL;
+    size_t length;
+
+    line = g_strconcat (answer, "\n", NULL);
+    length = strlen (line);
+
+    if (libreport_full_write (event->run_state->command_in_fd, line, length) != (ssize_t) length)
+    {
+        g_warning ("Failed to answer the event handler: %s", g_strerror (errno));
+    }
+}
+
+/* Answers that need no client interaction, either given in advance by the
+ * client, remembered by libreport, or given earlier by someone using the
+ * same context or by an earlier run of the same task.
+ */
+static char *
+reportd_task_lookup_answer (ReportdTask *self,
+                            PromptType   type,
+                            const char  *key,
+                            const char  *message)
+{
+    const char *value;
+    char *answer;
+
+    value = reportd_task_context_lookup_preset_answer (self->context, key, message);
+    if (NULL != value)
+    {
+        return g_strdup (value);
+    }
+
+    switch (type)
+    {
+        case ASK_YES_NO_YESFOREVER:
+        {
+            value = libreport_get_user_setting (key);
+            /* The following is replicating the madness inside libreport, where
+             * “no” means “yes, forever”, and “yes” means nothing, really.
+             *
+             * Yes (no?), each implementation has a similar comment.
+             */
+            if (value != NULL && !libreport_string_to_bool (value))
+            {
+                return g_strdup ("yes");
+            }
+        }
+        break;
+
+        case ASK_YES_NO_SAVE:
+        {
+            value = libreport_get_user_setting (key);
+            if (value != NULL)
+            {
+                return g_strdup (libreport_string_to_bool (value)? "yes" : "no");
+            }
+        }
+        break;
+
+        default:
+        {
+        }
+    }
+
+    answer = reportd_task_context_lookup_answer (self->context, type, message);
+    if (NULL == answer && ASK == type && NULL != self->resumed_answers)
+    {
+        g_autofree char *key = NULL;
+
+        key = reportd_journal_get_answer_key (type, message);
+        answer = g_strdup (g_hash_table_lookup (self->resumed_answers, key));
+    }
+
+    return answer;
+}
+
+static void reportd_task_show_prompt (ReportdTask *self);
+
+static void
+reportd_task_event_clear_prompt (ReportdTaskEvent *event)
+{
+    ReportdTask *self;
+
+    if (!event->prompting)
+    {
+        return;
+    }
+
+    self = event->task;
+
+    event->prompting = false;
+
+    g_clear_pointer (&event->prompt_key, g_free);
+    g_clear_pointer (&event->prompt_message, g_free);
+
+    if (self->prompting_event != event)
+    {
+        g_queue_remove (&self->prompt_queue, event);
+
+        return;
+    }
+
+    self->prompting_event = NULL;
+
+    /* Nobody is going to answer the questions still waiting, they are being
+     * cleared as well.
+     */
+    if (NULL != self->run_task && !g_cancellable_is_cancelled (self->cancellable))
+    {
+        reportd_task_show_prompt (self);
+    }
+}
+
+static bool
+reportd_task_prompt_handle_commit (ReportdDbusTaskPrompt *object,
+                                   GDBusMethodInvocation *invocation,
+                                   gpointer               user_data)
+{
+    ReportdTask *self;
+    ReportdTaskEvent *event;
+    g_autofree char *answer = NULL;
+
+    self = REPORTD_TASK (user_data);
+    event = self->prompting_event;
+
+    if (NULL == event)
+    {
+        g_dbus_method_invocation_return_error (invocation,
+                                               G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                                               "No question has been asked");
+
+        return true;
+    }
+
+    switch (event->prompt_type)
+    {
+        case ASK:
+        case ASK_PASSWORD:
+        {
+            const char *input;
+
+            input = reportd_dbus_task_prompt_get_input (object);
+
+            answer = g_strdup (NULL != input? input : "");
+        }
+        break;
+
+        case ASK_YES_NO:
+        case ASK_YES_NO_YESFOREVER:
+        case ASK_YES_NO_SAVE:
+        {
+            bool response;
+            bool remember;
+
+            response = reportd_dbus_task_prompt_get_response (object);
+            remember = reportd_dbus_task_prompt_get_remember (object);
+
+            if (ASK_YES_NO_YESFOREVER == event->prompt_type && remember && !response)
+            {
+                libreport_set_user_setting (event->prompt_key, "no");
+            }
+            else if (ASK_YES_NO_SAVE == event->prompt_type && remember)
+            {
+                libreport_set_user_setting (event->prompt_key, response? "yes" : "no");
+            }
+
+            answer = g_strdup (response? "yes" : "no");
+        }
+        break;
+    }
+
+    reportd_task_context_store_answer (self->context, event->prompt_type,
+                                       event->prompt_message, answer);
+    /* Passwords stay off the disk, and consent is asked for again. */
+    if (ASK == event->prompt_type && NULL != self->journal)
+    {
+        reportd_journal_add_answer (self->journal, event->prompt_type,
+                                    event->prompt_message, answer);
+    }
+
+    reportd_dbus_task_prompt_complete_commit (object, invocation);
+
+    reportd_task_event_clear_prompt (event);
+    reportd_task_event_answer (event, answer);
+    reportd_task_event_process_output (event);
+
+    return true;
+}
+
+/* Puts the next waiting question to the client. The prompt object is only
+ * exported once, with the answers of the previous question reset and the
+ * sequence number bumped for every question.
+ */
+static void
+reportd_task_show_prompt (ReportdTask *self)
+{
+    ReportdTaskEvent *event;
+    const char *object_path;
+
+    event = g_queue_pop_head (&self->prompt_queue);
+    if (NULL == event)
+    {
+        return;
+    }
+
+    self->prompting_event = event;
+
+    if (NULL == self->prompt_skeleton)
+    {
+        self->prompt_skeleton = g_dbus_object_skeleton_new (REPORTD_DBUS_TASK_PROMPT_PATH);
+        self->prompt_iface = reportd_dbus_task_prompt_skeleton_new ();
+
+        g_dbus_object_skeleton_add_interface (self->prompt_skeleton,
+                                              G_DBUS_INTERFACE_SKELETON (self->prompt_iface));
+
+        g_signal_connect (self->prompt_iface, "g-authorize-method",
+                          G_CALLBACK (reportd_task_on_authorize_method), self);
+        g_signal_connect (self->prompt_iface, "handle-commit",
+                          G_CALLBACK (reportd_task_prompt_handle_commit), self);
+
+        reportd_daemon_register_object (self->daemon, self->connection, self->prompt_skeleton);
+    }
+
+    reportd_dbus_task_prompt_set_input (self->prompt_iface, "");
+    reportd_dbus_task_prompt_set_response (self->prompt_iface, false);
+    reportd_dbus_task_prompt_set_remember (self->prompt_iface, false);
+    reportd_dbus_task_prompt_set_sequence (self->prompt_iface,
+                                           reportd_dbus_task_prompt_get_sequence (self->prompt_iface) + 1);
+
+    object_path = g_dbus_object_get_object_path (G_DBUS_OBJECT (self->prompt_skeleton));
+
+    /* The client will want to see what led up to the question. */
+    reportd_task_flush_progress (self);
+
+    if (!reportd_task_send_signal (self, "Prompt",
+                                   g_variant_new ("(ssu)", object_path,
+                                                  event->prompt_message, event->prompt_type)))
+    {
+        reportd_dbus_task_emit_prompt (self->task_iface, object_path,
+                                       event->prompt_message, event->prompt_type);
+    }
+}
+
+/* Queues the question for the client. Reading the command output is on hold
+ * until the prompt is committed, or until the task is canceled, which tears
+ * the prompt down right away; nothing polls in between.
+ */
+static void
+reportd_task_event_emit_prompt (ReportdTaskEvent *event,
+                                PromptType        type,
+                                const char       *key,
+                                const char       *message)
+{
+    ReportdTask *self;
+
+    self = event->task;
+
+    event->prompting = true;
+    event->prompt_type = type;
+    event->prompt_key = g_strdup (key);
+    event->prompt_message = g_strdup (message);
+
+    g_queue_push_tail (&self->prompt_queue, event);
+
+    if (NULL == self->prompting_event)
+    {
+        reportd_task_show_prompt (self);
+    }
+}
+
+static void reportd_task_event_terminate (ReportdTaskEvent *event);
+
+/* Deals with a question nobody has given an answer to in advance, as the
+ * client asked. Returns NULL if the question is to be put to the client or
+ * if the event has been made to fail.
+ */
+static char *
+reportd_task_event_get_default_answer (ReportdTaskEvent *event,
+                                       PromptType        type,
+                                       const char       *message)
+{
+    ReportdTaskContextUnanswered unanswered;
+    bool yes_no;
+
+    unanswered = reportd_task_context_get_unanswered (event->task->context);
+    yes_no = ASK != type && ASK_PASSWORD != type;
+
+    switch (unanswered)
+    {
+        case REPORTD_TASK_CONTEXT_UNANSWERED_ASK:
+        {
+            return NULL;
+        }
+
+        case REPORTD_TASK_CONTEXT_UNANSWERED_YES:
+        {
+            return g_strdup (yes_no? "yes" : "");
+        }
+
+        case REPORTD_TASK_CONTEXT_UNANSWERED_NO:
+        {
+            return g_strdup (yes_no? "no" : "");
+        }
+
+        case REPORTD_TASK_CONTEXT_UNANSWERED_FAIL:
+        {
+            event->unanswered = g_strdup (message);
+
+            reportd_task_event_terminate (event);
+        }
+        break;
+    }
+
+    return NULL;
+}
+
+/* Handles a line of the libreport client protocol. Returns false if the line
+ * is a question that has to wait for the client.
+ */
+static bool
+reportd_task_event_handle_output_line (ReportdTaskEvent *event,
+                                       char             *line)
+{
+    const struct
+    {
+        const char *prefix;
+        PromptType type;
+        /* The message is preceded by the key of the user setting */
+        bool keyed;
+    } questions[] =
+    {
+        { REPORT_PREFIX_ASK_YES_NO_YESFOREVER, ASK_YES_NO_YESFOREVER, true },
+        { REPORT_PREFIX_ASK_YES_NO_SAVE, ASK_YES_NO_SAVE, true },
+        { REPORT_PREFIX_ASK_YES_NO, ASK_YES_NO, false },
+        { REPORT_PREFIX_ASK_PASSWORD, ASK_PASSWORD, false },
+        { REPORT_PREFIX_ASK, ASK, false },
+    };
+
+    for (int i = 0; i < G_N_ELEMENTS (questions); i++)
+    {
+        char *key = NULL;
+        char *message;
+        g_autofree char *answer = NULL;
+
+        if (!g_str_has_prefix (line, questions[i].prefix))
+        {
+            continue;
+        }
+        /* The command is being killed, nobody is going to answer. */
+        if (g_cancellable_is_cancelled (event->task->cancellable) || NULL != event->unanswered)
+        {
+            return true;
+        }
+
+        message = line + strlen (questions[i].prefix);
+
+        if (questions[i].keyed)
+        {
+            key = message;
+            message = strchr (key, ' ');
+            if (NULL == message)
+            {
+                message = key + strlen (key);
+            }
+            else
+            {
+                *message++ = '\0';
+            }
+        }
+
+        answer = reportd_task_lookup_answer (event->task, questions[i].type, key, message);
+        if (NULL == answer)
+        {
+            answer = reportd_task_event_get_default_answer (event, questions[i].type, message);
+        }
+        if (NULL != answer)
+        {
+            reportd_task_event_answer (event, answer);
+
+            return true;
+        }
+        if (NULL != event->unanswered)
+        {
+            return true;
+        }
+
+        reportd_task_event_emit_prompt (event, questions[i].type, key, message);
+
+        return false;
+    }
+
+    reportd_task_emit_progress (event->task, line);
+
+    return true;
+}
+
+static void reportd_task_event_on_command_finished (ReportdTaskEvent *event);
+
+static gboolean
+reportd_task_event_on_command_output (int          fd,
+                                      GIOCondition condition,
+                                      gpointer     user_data)
+{
+    ReportdTaskEvent *event;
+    char buffer[4096];
+    ssize_t count;
+
+    event = user_data;
+
+    count = read (fd, buffer, sizeof (buffer));
+    if (count < 0 && (EAGAIN == errno || EINTR == errno))
+    {
+        return G_SOURCE_CONTINUE;
+    }
+    if (count > 0)
+    {
+        g_string_append_len (event->output, buffer, count);
+    }
+    else
+    {
+        if (count < 0)
+        {
+            g_warning ("Failed to read the event handler output: %s", g_strerror (errno));
+        }
+
+        event->output_done = true;
+    }
+
+    event->output_source_id = 0;
+
+    reportd_task_event_process_output (event);
+
+    return G_SOURCE_REMOVE;
+}
+
+/* Feeds complete lines to the protocol handler until the output runs dry or
+ * the command asks a question, then waits for more output.
+ */
+static void
+reportd_task_event_process_output (ReportdTaskEvent *event)
+{
+    while (!event->prompting)
+    {
+        char *end;
+        g_autofree char *line = NULL;
+
+        end = memchr (event->output->str, '\n', event->output->len);
+        if (NULL == end)
+        {
+            if (!event->output_done || 0 == event->output->len)
+            {
+                break;
+            }
+            /* The last line, lacking a line break */
+            end = event->output->str + event->output->len;
+        }
+
+        line = g_strndup (event->output->str, end - event->output->str);
+
+        g_string_erase (event->output, 0, MIN (event->output->len,
+                                               (gsize) (end - event->output->str) + 1));
+
+        reportd_task_event_handle_output_line (event, line);
+    }
+
+    if (event->prompting)
+    {
+        return;
+    }
+
+    if (event->output_done)
+    {
+        if (event->child_exited)
+        {
+            reportd_task_event_on_command_finished (event);
+        }
+
+        return;
+    }
+
+    if (0 == event->output_source_id)
+    {
+        event->output_source_id = g_unix_fd_add (event->run_state->command_out_fd,
+                                                 G_IO_IN | G_IO_HUP | G_IO_ERR,
+                                                 reportd_task_event_on_command_output,
+                                                 event);
+    }
+}
+
+static int
+reportd_task_pidfd_open (pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    return syscall (SYS_pidfd_open, pid, 0);
+#else
+    errno = ENOSYS;
+
+    return -1;
+#endif
+}
+
+static int
+reportd_task_pidfd_send_signal (int pidfd,
+                                int signum)
+{
+#ifdef SYS_pidfd_send_signal
+    return syscall (SYS_pidfd_send_signal, pidfd, signum, NULL, 0);
+#else
+    errno = ENOSYS;
+
+    return -1;
+#endif
+}
+
+static void
+reportd_task_event_on_child_exited (GPid     pid,
+                                    int      wait_status,
+                                    gpointer user_data)
+{
+    ReportdTaskEvent *event;
+
+    event = user_data;
+
+    event->child_watch_id = 0;
+    event->child_exited = true;
+    event->wait_status = wait_status;
+
+    g_clear_handle_id (&event->kill_source_id, g_source_remove);
+
+    g_spawn_close_pid (pid);
+
+    if (event->output_done && !event->prompting)
+    {
+        reportd_task_event_on_command_finished (event);
+    }
+}
+
+static gboolean
+reportd_task_event_on_pidfd_readable (int          fd,
+                                      GIOCondition condition,
+                                      gpointer     user_data)
+{
+    ReportdTaskEvent *event;
+    pid_t pid;
+    int wait_status = 0;
+
+    event = user_data;
+    pid = event->run_state->command_pid;
+
+    event->pidfd_source_id = 0;
+    close (event->pidfd);
+    event->pidfd = -1;
+
+    if (waitpid (pid, &wait_status, 0) < 0)
+    {
+        g_warning ("Failed to reap event handler %d: %s", pid, g_strerror (errno));
+    }
+
+    reportd_task_event_on_child_exited (pid, wait_status, event);
+
+    return G_SOURCE_REMOVE;
+}
+
+/* Signals the handler and its process group. The handler is only ever reaped
+ * on the main thread when pidfds are in use, so up until then neither its PID
+ * nor its process group ID can be reused.
+ */
+static void
+reportd_task_event_signal_command (ReportdTaskEvent *event,
+                                   int               signum)
+{
+    pid_t pid;
+
+    if (NULL == event->run_state || event->run_state->command_pid <= 0 || event->child_exited)
+    {
+        return;
+    }
+
+    pid = event->run_state->command_pid;
+
+    if (event->pidfd >= 0 && reportd_task_pidfd_send_signal (event->pidfd, signum) < 0)
+    {
+        g_warning ("Failed to signal event handler %d: %s", pid, g_strerror (errno));
+    }
+
+    kill (-pid, signum);
+}
+
+static gboolean
+reportd_task_event_on_kill_timeout (gpointer user_data)
+{
+    ReportdTaskEvent *event;
+
+    event = user_data;
+
+    event->kill_source_id = 0;
+
+    g_message ("Handler of event “%s” for task “%s” did not exit in time, killing it",
+               event->name, event->task->problem_path);
+
+    reportd_task_event_signal_command (event, SIGKILL);
+
+    return G_SOURCE_REMOVE;
+}
+
+/* Asks the running command to stop, killing it if it does not. */
+static void
+reportd_task_event_terminate (ReportdTaskEvent *event)
+{
+    if (EVENT_RUNNING == event->state && NULL != event->native_cancellable)
+    {
+        g_cancellable_cancel (event->native_cancellable);
+
+        return;
+    }
+    if (EVENT_RUNNING != event->state || NULL == event->run_state ||
+        event->run_state->command_pid <= 0)
+    {
+        return;
+    }
+
+    reportd_task_event_signal_command (event, SIGTERM);
+
+    if (0 == event->kill_source_id && !event->child_exited)
+    {
+        event->kill_source_id = g_timeout_add_seconds (REPORTD_TASK_KILL_TIMEOUT,
+                                                       reportd_task_event_on_kill_timeout,
+                                                       event);
+    }
+
+    /* Nobody is going to answer the question now, let the command run into
+     * the closed pipe instead.
+     */
+    if (event->prompting)
+    {
+        reportd_task_event_clear_prompt (event);
+        reportd_task_event_process_output (event);
+    }
+}
+
+/* The slot is held until the last running event of the task is done, even
+ * if the task has run out of time and its handlers are only being stopped,
+ * so that tasks never take up more capacity than the scheduler allows. Only
+ * tasks waiting on a duplicate to be reported let go of it early.
+ */
+static void
+reportd_task_release_job (ReportdTask *self)
+{
+    if (NULL == self->job)
+    {
+        return;
+    }
+
+    reportd_scheduler_job_done (reportd_daemon_get_scheduler (self->daemon), self->job);
+
+    self->job = NULL;
+}
+
+static gboolean
+reportd_task_event_on_deadline (gpointer user_data)
+{
+    ReportdTaskEvent *event;
+    ReportdTask *self;
+
+    event = user_data;
+    self = event->task;
+
+    event->deadline_source_id = 0;
+    event->timed_out = true;
+
+    g_message ("Event “%s” for task “%s” timed out, stopping it",
+               event->name, self->problem_path);
+
+    reportd_metrics_add_timeout (reportd_daemon_get_metrics (self->daemon), event->name);
+
+    reportd_task_event_terminate (event);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void reportd_task_finish (ReportdTask *self,
+                                 GError      *error);
+
+static bool
+reportd_task_stop_waiting_for_report (ReportdTask *self)
+{
+    ReportdWorkflowPlan *plan;
+
+    if (!self->waiting_for_report)
+    {
+        return false;
+    }
+
+    plan = reportd_task_context_get_plan (self->context);
+
+    reportd_report_index_forget_waiter (reportd_daemon_get_report_index (self->daemon, self->connection),
+                                        self->uid,
+                                        reportd_workflow_plan_get_workflow_name (plan),
+                                        self->duphash, self);
+
+    self->waiting_for_report = false;
+
+    return true;
+}
+
+static gboolean
+reportd_task_on_deadline (gpointer user_data)
+{
+    ReportdTask *self;
+    ReportdWorkflowPlan *plan;
+
+    self = REPORTD_TASK (user_data);
+    plan = reportd_task_context_get_plan (self->context);
+
+    self->deadline_source_id = 0;
+    self->timed_out = true;
+
+    g_message ("Workflow “%s” for task “%s” timed out, stopping it",
+               reportd_workflow_plan_get_workflow_name (plan), self->problem_path);
+
+    /* Whatever failed so far, running out of time is what stopped the task. */
+    g_clear_error (&self->error);
+    self->error = g_error_new (REPORTD_TASK_ERROR, REPORTD_TASK_ERROR_TIMED_OUT,
+                               "Workflow “%s” did not finish within %u seconds",
+                               reportd_workflow_plan_get_workflow_name (plan),
+                               reportd_workflow_plan_get_timeout (plan));
+
+    if (reportd_task_stop_waiting_for_report (self) ||
+        REPORTD_TASK_STATE_QUEUED == reportd_dbus_task_get_status (self->task_iface))
+    {
+        reportd_task_finish (self, g_steal_pointer (&self->error));
+
+        return G_SOURCE_REMOVE;
+    }
+
+    /* Terminating the last running event finishes the task. */
+    for (unsigned int i = 0; NULL != self->events && i < self->events->len; i++)
+    {
+        ReportdTaskEvent *event;
+
+        event = g_ptr_array_index (self->events, i);
+        if (EVENT_RUNNING != event->state)
+        {
+            continue;
+        }
+
+        reportd_metrics_add_timeout (reportd_daemon_get_metrics (self->daemon), event->name);
+        reportd_task_event_terminate (event);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+static ReportdTaskEvent *
+reportd_task_event_new (ReportdTask  *task,
+                        const char   *name,
+                        unsigned int  index)
+{
+    ReportdTaskEvent *event;
+
+    event = g_new0 (ReportdTaskEvent, 1);
+
+    event->task = task;
+    event->name = name;
+    event->index = index;
+    event->pidfd = -1;
+
+    return event;
+}
+
+static void
+reportd_task_event_free (ReportdTaskEvent *event)
+{
+    reportd_task_event_clear_prompt (event);
+
+    g_clear_handle_id (&event->output_source_id, g_source_remove);
+    g_clear_handle_id (&event->pidfd_source_id, g_source_remove);
+    g_clear_handle_id (&event->child_watch_id, g_source_remove);
+    g_clear_handle_id (&event->kill_source_id, g_source_remove);
+    g_clear_handle_id (&event->deadline_source_id, g_source_remove);
+
+    if (event->pidfd >= 0)
+    {
+        close (event->pidfd);
+    }
+    if (NULL != event->output)
+    {
+        g_string_free (event->output, TRUE);
+    }
+
+    g_clear_pointer (&event->run_state, free_run_event_state);
+    g_clear_pointer (&event->elements, g_hash_table_destroy);
+    g_clear_object (&event->native_cancellable);
+    g_free (event->results_key);
+    g_free (event->unanswered);
+
+    g_free (event);
+}
+
+/* Modification stamps of all the elements in the problem directory, for
+ * telling what an event has changed.
+ */
+static GHashTable *
+reportd_task_get_elements (ReportdTask *self)
+{
+    g_autoptr (GDir) directory = NULL;
+    g_autoptr (GError) error = NULL;
+    GHashTable *elements;
+    const char *name;
+
+    elements = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    directory = g_dir_open (self->problem_directory, 0, &error);
+    if (NULL == directory)
+    {
+        g_warning ("Failed to list “%s”: %s", self->problem_directory, error->message);
+
+        return elements;
+    }
+
+    while (NULL != (name = g_dir_read_name (directory)))
+    {
+        g_autofree char *path = NULL;
+        GStatBuf buffer;
+
+        path = g_build_filename (self->problem_directory, name, NULL);
+
+        if (g_stat (path, &buffer) == -1 || !S_ISREG (buffer.st_mode))
+        {
+            continue;
+        }
+
+        g_hash_table_insert (elements, g_strdup (name),
+                             g_strdup_printf ("%" G_GINT64_FORMAT ".%ld:%" G_GINT64_FORMAT,
+                                              (gint64) buffer.st_mtim.tv_sec,
+                                              (long) buffer.st_mtim.tv_nsec,
+                                              (gint64) buffer.st_size));
+    }
+
+    return elements;
+}
+
+/* Elements created or modified while the event was running. With events
+ * running side by side, that may include changes made by others, which only
+ * makes resuming more cautious.
+ */
+static GStrv
+reportd_task_event_get_changed_elements (ReportdTaskEvent *event)
+{
+    g_autoptr (GHashTable) elements = NULL;
+    GPtrArray *changed;
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+
+    if (NULL == event->elements)
+    {
+        return NULL;
+    }
+
+    elements = reportd_task_get_elements (event->task);
+    changed = g_ptr_array_new ();
+
+    g_hash_table_iter_init (&iter, elements);
+
+    while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+        if (g_strcmp0 (value, g_hash_table_lookup (event->elements, key)) != 0)
+        {
+            g_ptr_array_add (changed, g_strdup (key));
+        }
+    }
+
+    g_ptr_array_add (changed, NULL);
+
+    return (GStrv) g_ptr_array_free (changed, FALSE);
+}
+
+typedef struct
+{
+    ReportdTaskEvent *event;
+    ReportdResultCache *cache;
+    char *key;
+    char *problem_directory;
+    GStrv writes;
+
+    GError *error;
+} ReportdTaskResultStore;
+
+/* Copying the elements can take a while, so it is kept off the main
+ * thread, storing the elements the event declares writing that it left
+ * behind.
+ */
+static void
+reportd_task_result_store_thread (gpointer data)
+{
+    ReportdTaskResultStore *store;
+    g_autoptr (GPtrArray) elements = NULL;
+
+    store = data;
+    elements = g_ptr_array_new_with_free_func (g_free);
+
+    for (char **writes = store->writes; NULL != writes && NULL != *writes; writes++)
+    {
+        g_autofree char *path = NULL;
+
+        path = g_build_filename (store->problem_directory, *writes, NULL);
+
+        if (g_file_test (path, G_FILE_TEST_IS_REGULAR))
+        {
+            g_ptr_array_add (elements, g_strdup (*writes));
+        }
+    }
+
+    g_ptr_array_add (elements, NULL);
+
+    reportd_result_cache_store (store->cache, store->key, store->problem_directory,
+                                (const char * const *) elements->pdata, &store->error);
+}
+
+static void reportd_task_event_unblock_dependents (ReportdTaskEvent *event);
+static void reportd_task_schedule_events (ReportdTask *self);
+
+static void
+reportd_task_event_on_results_stored (gpointer data)
+{
+    ReportdTaskResultStore *store;
+    ReportdTaskEvent *event;
+    ReportdTask *self;
+
+    store = data;
+    event = store->event;
+    self = event->task;
+
+    if (NULL != store->error)
+    {
+        g_warning ("Failed to store results of event “%s”: %s", event->name, store->error->message);
+    }
+
+    g_object_unref (store->cache);
+    g_free (store->key);
+    g_free (store->problem_directory);
+    g_strfreev (store->writes);
+    g_clear_error (&store->error);
+    g_free (store);
+
+    reportd_task_event_unblock_dependents (event);
+
+    self->running_events--;
+
+    reportd_task_schedule_events (self);
+}
+
+/* Keeps what a pure event produced. The event counts as running until that
+ * is done, so that neither its dependents nor the end of the task get in
+ * the way of the copy.
+ */
+static void
+reportd_task_event_store_results (ReportdTaskEvent *event)
+{
+    ReportdTask *self;
+    ReportdTaskResultStore *store;
+
+    self = event->task;
+    store = g_new0 (ReportdTaskResultStore, 1);
+
+    store->event = event;
+    store->cache = g_object_ref (reportd_daemon_get_result_cache (self->daemon));
+    store->key = g_strdup (event->results_key);
+    store->problem_directory = g_strdup (self->problem_directory);
+    store->writes = g_strdupv ((char **) reportd_workflow_plan_get_event_writes (reportd_task_context_get_plan (self->context),
+                                                                                 event->index));
+
+    reportd_scheduler_run_in_thread (reportd_daemon_get_scheduler (self->daemon),
+                                     reportd_task_result_store_thread,
+                                     reportd_task_event_on_results_stored,
+                                     store);
+}
+
+static void
+reportd_task_event_unblock_dependents (ReportdTaskEvent *event)
+{
+    ReportdTask *self;
+    const unsigned int *dependents;
+    unsigned int n_dependents;
+
+    self = event->task;
+    dependents = reportd_workflow_plan_get_event_dependents (reportd_task_context_get_plan (self->context),
+                                                             event->index, &n_dependents);
+
+    for (unsigned int i = 0; i < n_dependents; i++)
+    {
+        ReportdTaskEvent *dependent;
+
+        dependent = g_ptr_array_index (self->events, dependents[i]);
+
+        dependent->blockers--;
+    }
+}
+
+static void
+reportd_task_event_finish (ReportdTaskEvent *event,
+                           int               exit_code)
+{
+    ReportdTask *self;
+    ReportdWorkflowPlan *plan;
+    bool storing = false;
+
+    self = event->task;
+    plan = reportd_task_context_get_plan (self->context);
+
+    free_commands (event->run_state);
+
+    event->state = EVENT_DONE;
+
+    g_clear_handle_id (&event->deadline_source_id, g_source_remove);
+
+    exit_code = reportd_workflow_plan_map_exit_code (plan, event->index, exit_code);
+
+    if (g_cancellable_is_cancelled (self->cancellable) || self->timed_out)
+    {
+        /* The outcome does not matter anymore. */
+    }
+    else if (event->timed_out || NULL != event->unanswered || 0 != exit_code)
+    {
+        /* With the events running in order, the first one to fail would
+         * have stopped the task, so that is the one to report.
+         */
+        if (NULL == self->failed_event || self->failed_event->index > event->index)
+        {
+            self->failed_event = event;
+
+            g_clear_error (&self->error);
+
+            if (event->timed_out)
+            {
+                self->error = g_error_new (REPORTD_TASK_ERROR, REPORTD_TASK_ERROR_TIMED_OUT,
+                                           "Event “%s” did not finish within %u seconds",
+                                           event->name,
+                                           reportd_workflow_plan_get_event_timeout (plan, event->index));
+            }
+            else if (NULL != event->unanswered)
+            {
+                self->error = g_error_new (REPORTD_TASK_ERROR, REPORTD_TASK_ERROR_UNANSWERED,
+                                           "Event “%s” asked “%s” with no answer given in advance",
+                                           event->name, event->unanswered);
+            }
+            else
+            {
+                /* Nothing was run (bad backtrace, user declined, etc... */
+                self->error = g_error_new (REPORTD_TASK_ERROR, REPORTD_TASK_ERROR_EVENT_HANDLER_FAILED,
+                                           "Event “%s” handler exited with code %d",
+                                           event->name, exit_code);
+            }
+        }
+    }
+    else
+    {
+        g_auto (GStrv) changed = NULL;
+
+        if (!event->cached && !event->native && 0 == event->run_state->children_count)
+        {
+            g_warning ("No processing specified for event “%s”", event->name);
+        }
+
+        changed = reportd_task_event_get_changed_elements (event);
+
+        if (NULL != self->journal)
+        {
+            reportd_journal_add_event (self->journal, event->name, (const char * const *) changed);
+        }
+        if (NULL != event->results_key && !event->cached)
+        {
+            reportd_task_event_store_results (event);
+
+            storing = true;
+        }
+        else
+        {
+            reportd_task_event_unblock_dependents (event);
+        }
+    }
+
+    g_clear_pointer (&event->run_state, free_run_event_state);
+    g_clear_pointer (&event->elements, g_hash_table_destroy);
+    if (NULL != event->output)
+    {
+        g_string_free (event->output, TRUE);
+        event->output = NULL;
+    }
+
+    if (storing)
+    {
+        return;
+    }
+
+    self->running_events--;
+
+    reportd_task_schedule_events (self);
+}
+
+/* glibc has no wrapper for ioprio_set(). */
+#define REPORTD_TASK_IOPRIO_WHO_PGRP 2
+#define REPORTD_TASK_IOPRIO_CLASS_SHIFT 13
+#define REPORTD_TASK_IOPRIO_CLASS_BE 2
+#define REPORTD_TASK_IOPRIO_CLASS_IDLE 3
+#define REPORTD_TASK_IOPRIO_BE_LOWEST 7
+
+/* Applied to the process group of the handler right after it is spawned,
+ * as libreport offers no way in before exec. Processes the handler starts
+ * later on inherit the scheduler from it.
+ */
+static void
+reportd_task_event_apply_priority (ReportdTaskEvent *event)
+{
+    const ReportdEventPriority *priority;
+    pid_t pid;
+
+    priority = reportd_workflow_plan_get_event_priority (reportd_task_context_get_plan (event->task->context),
+                                                         event->index);
+    pid = event->run_state->command_pid;
+
+    if (0 != priority->nice)
+    {
+        int niceness;
+
+        errno = 0;
+        niceness = getpriority (PRIO_PROCESS, 0);
+        if (0 == errno && -1 == setpriority (PRIO_PGRP, pid, MIN (niceness + priority->nice, 19)))
+        {
+            g_message ("Failed to lower the priority of handler of event “%s”: %s",
+                       event->name, g_strerror (errno));
+        }
+    }
+
+    if (REPORTD_EVENT_IO_CLASS_DEFAULT != priority->io_class)
+    {
+        int ioprio;
+
+        if (REPORTD_EVENT_IO_CLASS_IDLE == priority->io_class)
+        {
+            ioprio = REPORTD_TASK_IOPRIO_CLASS_IDLE << REPORTD_TASK_IOPRIO_CLASS_SHIFT;
+        }
+        else
+        {
+            ioprio = (REPORTD_TASK_IOPRIO_CLASS_BE << REPORTD_TASK_IOPRIO_CLASS_SHIFT) |
+                     REPORTD_TASK_IOPRIO_BE_LOWEST;
+        }
+
+        if (-1 == syscall (SYS_ioprio_set, REPORTD_TASK_IOPRIO_WHO_PGRP, pid, ioprio))
+        {
+            g_message ("Failed to set the I/O class of handler of event “%s”: %s",
+                       event->name, g_strerror (errno));
+        }
+    }
+
+    if (REPORTD_EVENT_SCHEDULER_DEFAULT != priority->scheduler)
+    {
+        struct sched_param param = { 0, };
+        int policy;
+
+        policy = REPORTD_EVENT_SCHEDULER_IDLE == priority->scheduler? SCHED_IDLE : SCHED_BATCH;
+
+        if (-1 == sched_setscheduler (pid, policy, &param))
+        {
+            g_message ("Failed to set the scheduler of handler of event “%s”: %s",
+                       event->name, g_strerror (errno));
+        }
+    }
+}
+
+static void
+reportd_task_event_spawn_next_command (ReportdTaskEvent *event)
+{
+    ReportdTask *self;
+    struct run_event_state *state;
+    gint64 spawn_time;
+
+    self = event->task;
+    state = event->run_state;
+    spawn_time = g_get_monotonic_time ();
+
+    if (spawn_next_command (state, self->problem_directory, event->name, EXECFLG_SETPGID) < 0)
+    {
+        reportd_task_event_finish (event, 0);
+
+        return;
+    }
+
+    reportd_metrics_add_spawn (reportd_daemon_get_metrics (self->daemon),
+                               g_get_monotonic_time () - spawn_time);
+
+    reportd_task_event_apply_priority (event);
+
+    event->output_done = false;
+    event->child_exited = false;
+
+    g_string_truncate (event->output, 0);
+    g_unix_set_fd_nonblocking (state->command_out_fd, true, NULL);
+
+    event->pidfd = reportd_task_pidfd_open (state->command_pid);
+    if (event->pidfd >= 0)
+    {
+        event->pidfd_source_id = g_unix_fd_add (event->pidfd, G_IO_IN,
+                                                reportd_task_event_on_pidfd_readable, event);
+    }
+    else
+    {
+        event->child_watch_id = g_child_watch_add (state->command_pid,
+                                                   reportd_task_event_on_child_exited, event);
+    }
+
+    reportd_task_event_process_output (event);
+}
+
+static void
+reportd_task_event_on_command_finished (ReportdTaskEvent *event)
+{
+    struct run_event_state *state;
+    int exit_code = 0;
+
+    state = event->run_state;
+
+    close (state->command_out_fd);
+    close (state->command_in_fd);
+
+    state->command_out_fd = -1;
+    state->command_in_fd = -1;
+    state->command_pid = 0;
+
+    if (WIFEXITED (event->wait_status))
+    {
+        exit_code = WEXITSTATUS (event->wait_status);
+    }
+    else if (WIFSIGNALED (event->wait_status))
+    {
+        exit_code = WTERMSIG (event->wait_status) + 128;
+    }
+
+    if (0 != exit_code || event->timed_out || event->task->timed_out ||
+        g_cancellable_is_cancelled (event->task->cancellable))
+    {
+        reportd_task_event_finish (event, exit_code);
+
+        return;
+    }
+
+    reportd_task_event_spawn_next_command (event);
+}
+
+typedef struct
+{
+    ReportdTaskEvent *event;
+    ReportdEventExecutor executor;
+    ReportdEventRun *run;
+    int exit_code;
+} ReportdTaskNativeRun;
+
+static void
+reportd_task_native_run_thread (gpointer data)
+{
+    ReportdTaskNativeRun *native_run;
+
+    native_run = data;
+    native_run->exit_code = native_run->executor (native_run->run);
+}
+
+static void
+reportd_task_event_on_native_run_done (gpointer data)
+{
+    ReportdTaskNativeRun *native_run;
+    ReportdTaskEvent *event;
+    g_auto (GStrv) log = NULL;
+    int exit_code;
+
+    native_run = data;
+    event = native_run->event;
+    log = reportd_event_run_steal_log (native_run->run);
+    exit_code = native_run->exit_code;
+
+    reportd_event_run_free (native_run->run);
+    g_free (native_run);
+
+    for (char **line = log; NULL != *line; line++)
+    {
+        reportd_task_emit_progress (event->task, *line);
+    }
+
+    g_clear_object (&event->native_cancellable);
+
+    reportd_task_event_finish (event, exit_code);
+}
+
+/* Runs the handlers of the event, in a worker thread if a plugin has an
+ * executor for it and by the commands of the libreport rules otherwise.
+ */
+static void
+reportd_task_event_run_handlers (ReportdTaskEvent *event)
+{
+    ReportdTask *self;
+    ReportdExecutorRegistry *registry;
+    ReportdEventExecutor executor = NULL;
+    ReportdTaskNativeRun *native_run;
+    const char * const *environment;
+
+    self = event->task;
+    registry = reportd_daemon_get_executor_registry (self->daemon);
+    if (NULL != registry)
+    {
+        executor = reportd_executor_registry_lookup (registry, event->name);
+    }
+
+    if (NULL == executor)
+    {
+        prepare_commands (event->run_state);
+
+        reportd_task_event_spawn_next_command (event);
+
+        return;
+    }
+
+    environment = reportd_workflow_plan_get_event_environment (reportd_task_context_get_plan (self->context),
+                                                               event->index);
+
+    event->native = true;
+    event->native_cancellable = g_cancellable_new ();
+
+    native_run = g_new0 (ReportdTaskNativeRun, 1);
+
+    native_run->event = event;
+    native_run->executor = executor;
+    native_run->run = reportd_event_run_new (event->name, self->problem_directory,
+                                             environment, event->native_cancellable);
+
+    reportd_scheduler_run_in_thread (reportd_daemon_get_scheduler (self->daemon),
+                                     reportd_task_native_run_thread,
+                                     reportd_task_event_on_native_run_done,
+                                     native_run);
+}
+
+typedef struct
+{
+    ReportdTaskEvent *event;
+    ReportdResultCache *cache;
+    char *event_name;
+    GStrv environment;
+    GStrv reads;
+    char *problem_directory;
+
+    char *key;
+    bool hit;
+    GError *error;
+} ReportdTaskResultLookup;
+
+static void
+reportd_task_result_lookup_free (ReportdTaskResultLookup *lookup)
+{
+    g_object_unref (lookup->cache);
+    g_free (lookup->event_name);
+    g_strfreev (lookup->environment);
+    g_strfreev (lookup->reads);
+    g_free (lookup->problem_directory);
+    g_free (lookup->key);
+    g_clear_error (&lookup->error);
+
+    g_free (lookup);
+}
+
+/* Hashing the inputs means reading the likes of core dumps, so it is kept
+ * off the main thread.
+ */
+static void
+reportd_task_result_lookup_thread (gpointer data)
+{
+    ReportdTaskResultLookup *lookup;
+
+    lookup = data;
+    lookup->key = reportd_result_cache_compute_key (lookup->event_name,
+                                                    (const char * const *) lookup->environment,
+                                                    lookup->problem_directory,
+                                                    (const char * const *) lookup->reads,
+                                                    &lookup->error);
+    if (NULL == lookup->key)
+    {
+        return;
+    }
+
+    lookup->hit = reportd_result_cache_restore (lookup->cache, lookup->key,
+                                                lookup->problem_directory, &lookup->error);
+}
+
+static void
+reportd_task_event_on_results_looked_up (gpointer data)
+{
+    ReportdTaskResultLookup *lookup;
+    ReportdTaskEvent *event;
+    ReportdTask *self;
+    bool hit;
+
+    lookup = data;
+    event = lookup->event;
+    self = event->task;
+    hit = lookup->hit;
+
+    if (NULL != lookup->error)
+    {
+        g_warning ("Failed to look up results of event “%s”: %s", event->name, lookup->error->message);
+    }
+
+    reportd_metrics_add_result_lookup (reportd_daemon_get_metrics (self->daemon), hit);
+
+    event->results_key = g_steal_pointer (&lookup->key);
+    event->cached = hit;
+
+    reportd_task_result_lookup_free (lookup);
+
+    if (hit)
+    {
+        g_message ("Reusing results of event “%s” for task “%s”", event->name, self->problem_path);
+    }
+
+    if (hit || event->timed_out || self->timed_out || g_cancellable_is_cancelled (self->cancellable))
+    {
+        reportd_task_event_finish (event, 0);
+
+        return;
+    }
+
+    reportd_task_event_run_handlers (event);
+}
+
+static void
+reportd_task_event_look_up_results (ReportdTaskEvent *event)
+{
+    ReportdTask *self;
+    ReportdWorkflowPlan *plan;
+    ReportdTaskResultLookup *lookup;
+
+    self = event->task;
+    plan = reportd_task_context_get_plan (self->context);
+    lookup = g_new0 (ReportdTaskResultLookup, 1);
+
+    lookup->event = event;
+    lookup->cache = g_object_ref (reportd_daemon_get_result_cache (self->daemon));
+    lookup->event_name = g_strdup (event->name);
+    lookup->environment = g_strdupv ((char **) reportd_workflow_plan_get_event_environment (plan, event->index));
+    lookup->reads = g_strdupv ((char **) reportd_workflow_plan_get_event_reads (plan, event->index));
+    lookup->problem_directory = g_strdup (self->problem_directory);
+
+    reportd_scheduler_run_in_thread (reportd_daemon_get_scheduler (self->daemon),
+                                     reportd_task_result_lookup_thread,
+                                     reportd_task_event_on_results_looked_up,
+                                     lookup);
+}
+
+static void
+reportd_task_event_start (ReportdTaskEvent *event)
+{
+    ReportdTask *self;
+    unsigned int timeout;
+
+    self = event->task;
+    timeout = reportd_workflow_plan_get_event_timeout (reportd_task_context_get_plan (self->context),
+                                                       event->index);
+
+    event->state = EVENT_RUNNING;
+    self->running_events++;
+
+    if (0 != timeout)
+    {
+        event->deadline_source_id = g_timeout_add_seconds (timeout,
+                                                           reportd_task_event_on_deadline,
+                                                           event);
+    }
+
+    event->run_state = new_run_event_state ();
+
+    event->run_state->logging_callback = do_log2;
+    event->run_state->logging_param = self;
+    event->run_state->error_callback = reportd_task_error_callback;
+    event->run_state->error_param = self;
+
+    event->output = g_string_new (NULL);
+
+    if (NULL != self->journal)
+    {
+        event->elements = reportd_task_get_elements (self);
+    }
+
+    reportd_task_event_set_environment (event);
+
+    if (reportd_workflow_plan_get_event_pure (reportd_task_context_get_plan (self->context), event->index) &&
+        NULL != reportd_daemon_get_result_cache (self->daemon))
+    {
+        reportd_task_event_look_up_results (event);
+
+        return;
+    }
+
+    reportd_task_event_run_handlers (event);
+}
+
+static void
+reportd_task_plan_events (ReportdTask *self)
+{
+    ReportdWorkflowPlan *plan;
+    unsigned int n_events;
+
+    plan = reportd_task_context_get_plan (self->context);
+    n_events = reportd_workflow_plan_get_n_events (plan);
+
+    self->events = g_ptr_array_new_full (n_events, (GDestroyNotify) reportd_task_event_free);
+
+    for (unsigned int i = 0; i < n_events; i++)
+    {
+        ReportdTaskEvent *event;
+
+        event = reportd_task_event_new (self, reportd_workflow_plan_get_event_name (plan, i), i);
+        event->blockers = reportd_workflow_plan_get_event_blockers (plan, i);
+
+        g_ptr_array_add (self->events, event);
+    }
+}
+
+/* Skips the events a previous run of the task got through, as long as the
+ * elements they changed are still there. Anything depending on an event that
+ * has to run again runs again too. Text answers are only given again if the
+ * previous run was cut short by the daemon going away.
+ */
+static void
+reportd_task_replay_journal (ReportdTask *self)
+{
+    self->resumed_answers = reportd_journal_steal_answers (self->journal);
+
+    for (unsigned int i = 0; i < self->events->len; i++)
+    {
+        ReportdTaskEvent *event;
+        const char * const *elements = NULL;
+        bool complete = true;
+
+        event = g_ptr_array_index (self->events, i);
+
+        if (0 != event->blockers || !reportd_journal_lookup_event (self->journal, event->name, &elements))
+        {
+            continue;
+        }
+
+        for (; NULL != elements && NULL != *elements && complete; elements++)
+        {
+            g_autofree char *path = NULL;
+
+            path = g_build_filename (self->problem_directory, *elements, NULL);
+
+            complete = g_file_test (path, G_FILE_TEST_IS_REGULAR);
+        }
+
+        if (!complete)
+        {
+            continue;
+        }
+
+        g_message ("Event “%s” for task “%s” already completed, skipping",
+                   event->name, self->problem_path);
+
+        event->state = EVENT_DONE;
+
+        reportd_task_event_unblock_dependents (event);
+    }
+}
+
+static void reportd_task_push (ReportdTask *self);
+
+/* Starts every event that is not waiting on another one. Once a failure or
+ * cancellation is known, only lets the running events come to an end.
+ */
+static void
+reportd_task_schedule_events (ReportdTask *self)
+{
+    bool done = true;
+
+    if (NULL == self->error && !g_cancellable_is_cancelled (self->cancellable))
+    {
+        for (unsigned int i = 0; i < self->events->len; i++)
+        {
+            ReportdTaskEvent *event;
+
+            event = g_ptr_array_index (self->events, i);
+
+            if (EVENT_DONE != event->state)
+            {
+                done = false;
+            }
+            if (EVENT_WAITING == event->state && 0 == event->blockers)
+            {
+                reportd_task_event_start (event);
+
+                /* Starting an event can finish it right away, and with it
+                 * everything else.
+                 */
+                if (NULL == self->events)
+                {
+                    return;
+                }
+            }
+        }
+    }
+
+    if (0 != self->running_events)
+    {
+        return;
+    }
+
+    if (NULL != self->error)
+    {
+        reportd_task_finish (self, g_steal_pointer (&self->error));
+    }
+    else if (g_cancellable_is_cancelled (self->cancellable))
+    {
+        reportd_task_finish (self, g_error_new_literal (G_IO_ERROR, G_IO_ERROR_CANCELLED,
+                                                        "Operation was cancelled"));
+    }
+    else if (done)
+    {
+        /* Storing the results is not up to the handlers. */
+        g_clear_handle_id (&self->deadline_source_id, g_source_remove);
+
+        reportd_task_push (self);
+    }
+}
+
+static char *
+reportd_task_read_element (ReportdTask *self,
+                           const char  *name)
+{
+    g_autofree char *path = NULL;
+    char *contents = NULL;
+
+    path = g_build_filename (self->problem_directory, name, NULL);
+
+    g_file_get_contents (path, &contents, NULL, NULL);
+
+    return contents;
+}
+
+/* Takes over where a duplicate of the problem has been reported, without
+ * running any of the events.
+ */
+static void
+reportd_task_reuse_report (ReportdTask *self,
+                           const char  *reported_to)
+{
+    g_autofree char *path = NULL;
+    g_autofree char *contents = NULL;
+    g_autofree char *new_contents = NULL;
+    g_autoptr (GError) error = NULL;
+    g_auto (GStrv) lines = NULL;
+
+    g_message ("A duplicate of “%s” has been reported already", self->problem_path);
+
+    lines = g_strsplit (reported_to, "\n", -1);
+
+    for (char **line = lines; NULL != *line; line++)
+    {
+        g_autofree char *message = NULL;
+
+        if ('\0' == **line)
+        {
+            continue;
+        }
+
+        message = g_strdup_printf ("Already reported: %s", *line);
+
+        reportd_task_emit_progress (self, message);
+    }
+
+    path = g_build_filename (self->problem_directory, FILENAME_REPORTED_TO, NULL);
+    contents = reportd_task_read_element (self, FILENAME_REPORTED_TO);
+    new_contents = g_strconcat (NULL != contents? contents : "", reported_to, NULL);
+
+    if (!g_file_set_contents (path, new_contents, -1, &error))
+    {
+        g_warning ("Failed to update “%s”: %s", path, error->message);
+    }
+
+    for (unsigned int i = 0; i < self->events->len; i++)
+    {
+        ReportdTaskEvent *event;
+
+        event = g_ptr_array_index (self->events, i);
+
+        event->state = EVENT_DONE;
+    }
+
+    reportd_task_schedule_events (self);
+}
+
+static void reportd_task_on_queue_position_changed (ReportdSchedulerJob *job,
+                                                    unsigned int         position,
+                                                    gpointer             user_data);
+
+static void
+reportd_task_on_redispatched (ReportdSchedulerJob *job,
+                              gpointer             user_data)
+{
+    ReportdTask *self;
+
+    self = REPORTD_TASK (user_data);
+
+    reportd_dbus_task_set_queue_position (self->task_iface, 0);
+    reportd_dbus_task_set_status (self->task_iface, REPORTD_TASK_STATE_RUNNING);
+
+    reportd_task_schedule_events (self);
+}
+
+static void
+reportd_task_on_duplicate_reported (const char *reported_to,
+                                    gpointer    user_data)
+{
+    ReportdTask *self;
+
+    self = REPORTD_TASK (user_data);
+
+    self->waiting_for_report = false;
+
+    if (NULL != reported_to)
+    {
+        reportd_task_reuse_report (self, reported_to);
+
+        return;
+    }
+
+    /* The report failed and it is up to this task to have a go at it, once
+     * it gets a slot again.
+     */
+    self->reporting = true;
+    self->reported_to = reportd_task_read_element (self, FILENAME_REPORTED_TO);
+
+    reportd_dbus_task_set_status (self->task_iface, REPORTD_TASK_STATE_QUEUED);
+
+    self->job = reportd_scheduler_queue (reportd_daemon_get_scheduler (self->daemon),
+                                         self->owner, self->priority,
+                                         reportd_task_on_redispatched,
+                                         reportd_task_on_queue_position_changed,
+                                         self);
+}
+
+/* Problems sharing a duphash are reported once per workflow and user, if
+ * the workflow asks for it: by the first task to get to them, while the
+ * others wait to reuse the outcome without holding on to a slot.
+ */
+static void
+reportd_task_check_duplicates (ReportdTask *self)
+{
+    ReportdWorkflowPlan *plan;
+    const char *reported_to = NULL;
+
+    plan = reportd_task_context_get_plan (self->context);
+
+    if (!reportd_workflow_plan_get_deduplicate (plan))
+    {
+        reportd_task_schedule_events (self);
+
+        return;
+    }
+
+    if (NULL == self->duphash)
+    {
+        self->duphash = reportd_task_read_element (self, FILENAME_DUPHASH);
+    }
+    if (NULL == self->duphash)
+    {
+        self->duphash = reportd_task_read_element (self, FILENAME_UUID);
+    }
+    if (NULL == self->duphash)
+    {
+        reportd_task_schedule_events (self);
+
+        return;
+    }
+
+    g_strstrip (self->duphash);
+
+    self->uid = reportd_task_read_element (self, FILENAME_UID);
+    if (NULL != self->uid)
+    {
+        g_strstrip (self->uid);
+    }
+
+    switch (reportd_report_index_claim (reportd_daemon_get_report_index (self->daemon, self->connection),
+                                        self->uid,
+                                        reportd_workflow_plan_get_workflow_name (plan),
+                                        self->duphash, &reported_to,
+                                        reportd_task_on_duplicate_reported, self))
+    {
+        case REPORTD_REPORT_INDEX_CLAIMED:
+        {
+            self->reporting = true;
+            self->reported_to = reportd_task_read_element (self, FILENAME_REPORTED_TO);
+
+            reportd_task_schedule_events (self);
+        }
+        break;
+
+        case REPORTD_REPORT_INDEX_IN_FLIGHT:
+        {
+            g_message ("Waiting for a duplicate of “%s” to be reported", self->problem_path);
+
+            self->waiting_for_report = true;
+
+            reportd_task_release_job (self);
+            reportd_task_emit_progress (self, "Waiting for a duplicate problem to be reported");
+        }
+        break;
+
+        case REPORTD_REPORT_INDEX_REPORTED:
+        {
+            reportd_task_reuse_report (self, reported_to);
+        }
+        break;
+    }
+}
+
+/* Lets the duplicates waiting on the task know where the problem ended up,
+ * if anywhere new.
+ */
+static void
+reportd_task_release_report (ReportdTask *self,
+                             bool         succeeded)
+{
+    ReportdWorkflowPlan *plan;
+    g_autofree char *reported_to = NULL;
+    const char *added = NULL;
+
+    if (!self->reporting)
+    {
+        return;
+    }
+
+    plan = reportd_task_context_get_plan (self->context);
+
+    if (succeeded)
+    {
+        const char *before;
+
+        before = NULL != self->reported_to? self->reported_to : "";
+        reported_to = reportd_task_read_element (self, FILENAME_REPORTED_TO);
+
+        if (NULL != reported_to && g_str_has_prefix (reported_to, before) &&
+            '\0' != reported_to[strlen (before)])
+        {
+            added = reported_to + strlen (before);
+        }
+    }
+
+    self->reporting = false;
+
+    reportd_report_index_release (reportd_daemon_get_report_index (self->daemon, self->connection),
+                                  self->uid,
+                                  reportd_workflow_plan_get_workflow_name (plan),
+                                  self->duphash, added);
+}
+
+/* Moving the problem directory around is left to the workers, as it may
+ * take a while.
+ */
+typedef struct
+{
+    ReportdTask *task;
+    char *problem_directory;
+    GError *error;
+} ReportdTaskTransfer;
+
+static ReportdTaskTransfer *
+reportd_task_transfer_new (ReportdTask *task)
+{
+    ReportdTaskTransfer *transfer;
+
+    transfer = g_new0 (ReportdTaskTransfer, 1);
+
+    transfer->task = g_object_ref (task);
+
+    return transfer;
+}
+
+static void
+reportd_task_transfer_free (ReportdTaskTransfer *transfer)
+{
+    g_object_unref (transfer->task);
+    g_free (transfer->problem_directory);
+    g_clear_error (&transfer->error);
+
+    g_free (transfer);
+}
+
+/* The error to finish the task with, if any. */
+static GError *
+reportd_task_transfer_steal_error (ReportdTaskTransfer *transfer)
+{
+    if (NULL == transfer->error)
+    {
+        g_cancellable_set_error_if_cancelled (transfer->task->cancellable, &transfer->error);
+    }
+
+    return g_steal_pointer (&transfer->error);
+}
+
+static void
+reportd_task_pull_thread (gpointer data)
+{
+    ReportdTaskTransfer *transfer;
+    ReportdTask *self;
+
+    transfer = data;
+    self = transfer->task;
+
+    transfer->problem_directory = reportd_daemon_get_problem_directory (self->daemon,
+                                                                        self->connection,
+                                                                        self->problem_path,
+                                                                        &transfer->error);
+}
+
+static void
+reportd_task_push_thread (gpointer data)
+{
+    ReportdTaskTransfer *transfer;
+    ReportdTask *self;
+
+    transfer = data;
+    self = transfer->task;
+
+    reportd_daemon_push_problem_directory (self->daemon, self->connection,
+                                           self->problem_directory, &transfer->error);
+}
+
+static void
+reportd_task_on_pushed (gpointer data)
+{
+    ReportdTaskTransfer *transfer;
+
+    transfer = data;
 
-    reportd_dbus_task_emit_progress (self->task_iface, log_line);
+    reportd_task_finish (transfer->task, reportd_task_transfer_steal_error (transfer));
 
-    return log_line;
+    reportd_task_transfer_free (transfer);
 }
 
 static void
-reportd_task_error_callback (const char *error_line,
-                             void       *param)
+reportd_task_push (ReportdTask *self)
 {
-    ReportdTask *self;
-
-    self = REPORTD_TASK (param);
-
-    reportd_dbus_task_emit_progress (self->task_iface, error_line);
+    reportd_scheduler_run_in_thread (reportd_daemon_get_scheduler (self->daemon),
+                                     reportd_task_push_thread,
+                                     reportd_task_on_pushed,
+                                     reportd_task_transfer_new (self));
 }
 
-static int
-export_config_and_run_event (struct run_event_state *state,
-                             const char             *dump_dir_name,
-                             const char             *event)
+static void
+reportd_task_on_pulled (gpointer data)
 {
-    GList *env_list;
-    int retval;
+    ReportdTaskTransfer *transfer;
+    ReportdTask *self;
+    GError *error;
+    ReportdWorkflowPlan *plan;
+    unsigned int timeout;
+    g_autofree char *journal_path = NULL;
+
+    transfer = data;
+    self = transfer->task;
+    plan = reportd_task_context_get_plan (self->context);
 
-    env_list = export_event_config (event);
+    error = reportd_task_transfer_steal_error (transfer);
+    if (NULL != error)
+    {
+        reportd_task_finish (self, error);
+        reportd_task_transfer_free (transfer);
+
+        return;
+    }
 
-    prepare_commands (state);
+    self->problem_directory = g_steal_pointer (&transfer->problem_directory);
 
-    while (spawn_next_command (state, dump_dir_name, event, EXECFLG_SETPGID) >= 0)
+    timeout = reportd_workflow_plan_get_timeout (plan);
+    if (0 != timeout)
     {
-        retval = consume_event_command_output (state, dump_dir_name);
-        if (0 != retval)
-        {
-            break;
-        }
+        self->deadline_source_id = g_timeout_add_seconds (timeout, reportd_task_on_deadline, self);
     }
 
-    free_commands (state);
-    unexport_event_config (env_list);
+    journal_path = g_strdup_printf ("%s.%s.journal", self->problem_directory,
+                                    reportd_workflow_plan_get_workflow_name (plan));
+    self->journal = reportd_journal_new (journal_path);
 
-    return retval;
+    reportd_task_plan_events (self);
+    reportd_task_replay_journal (self);
+    reportd_task_check_duplicates (self);
+
+    reportd_task_transfer_free (transfer);
 }
 
-static bool
-reportd_task_run_event_chain (ReportdTask             *self,
-                              const char              *dump_dir_name,
-                              GList                   *chain,
-                              GError                 **error)
+static void
+reportd_task_finish (ReportdTask *self,
+                     GError      *error)
 {
-    for (GList *l = chain; NULL != l; l = l->next)
-    {
-        const char *event_name;
-        int exit_code;
-        const struct
-        {
-            const char *event_name;
-            int quirk_code;
-            int quirk_mapping;
-        } quirks[] =
-        {
-            /* For some reason, abrt-action-ureport exits if it detects a
-             * Bugzilla report…
-             */
-            { "report_uReport", 70, 0 },
-        };
-
-        event_name = l->data;
+    g_autoptr (GTask) task = NULL;
 
-        if (g_cancellable_set_error_if_cancelled (self->cancellable, error))
-        {
-            return false;
-        }
+    task = g_steal_pointer (&self->run_task);
 
-        exit_code = export_config_and_run_event (self->run_state, dump_dir_name, event_name);
+    reportd_task_release_job (self);
+    reportd_task_stop_waiting_for_report (self);
+    reportd_task_release_report (self, NULL == error);
+    g_clear_handle_id (&self->deadline_source_id, g_source_remove);
 
-        if (g_cancellable_set_error_if_cancelled (self->cancellable, error))
+    g_clear_pointer (&self->events, g_ptr_array_unref);
+    g_clear_pointer (&self->problem_directory, g_free);
+    if (NULL != self->journal && NULL == error)
+    {
+        reportd_journal_remove (self->journal);
+    }
+    else if (NULL != self->journal)
+    {
+        reportd_journal_end_run (self->journal);
+    }
+    g_clear_object (&self->journal);
+    g_clear_pointer (&self->resumed_answers, g_hash_table_destroy);
+    g_clear_pointer (&self->duphash, g_free);
+    g_clear_pointer (&self->uid, g_free);
+    g_clear_pointer (&self->reported_to, g_free);
+    g_clear_error (&self->error);
+    self->failed_event = NULL;
+    self->running_events = 0;
+    self->timed_out = false;
+
+    reportd_task_flush_progress (self);
+    reportd_dbus_task_set_queue_position (self->task_iface, 0);
+
+    if (NULL != error)
+    {
+        if (g_cancellable_is_cancelled (self->cancellable))
         {
-            return false;
+            reportd_dbus_task_set_status (self->task_iface, REPORTD_TASK_STATE_CANCELED);
         }
-
-        for (int i = 0; i < G_N_ELEMENTS (quirks); i++)
+        else
         {
-            if (g_strcmp0 (quirks[i].event_name, event_name) == 0 &&
-                quirks[i].quirk_code == exit_code)
-            {
-                g_message ("Correcting quirk: event “%s” exited with code %d; replacing with %d",
-                           event_name, exit_code, quirks[i].quirk_mapping);
-
-                exit_code = quirks[i].quirk_mapping;
-            }
+            reportd_dbus_task_set_status (self->task_iface, REPORTD_TASK_STATE_FAILED);
         }
 
-        if (0 != exit_code)
-        {
-            /* Nothing was run (bad backtrace, user declined, etc... */
-            g_set_error (error, REPORTD_TASK_ERROR, REPORTD_TASK_ERROR_EVENT_HANDLER_FAILED,
-                         "Event “%s” handler exited with code %d", event_name, exit_code);
+        g_task_return_error (task, error);
+    }
+    else
+    {
+        reportd_dbus_task_set_status (self->task_iface, REPORTD_TASK_STATE_COMPLETED);
 
-            return false;
-        }
-        else if (0 == self->run_state->children_count)
-        {
-            g_warning ("No processing specified for event “%s”", event_name);
-        }
+        g_task_return_boolean (task, true);
     }
 
-    return true;
+    g_signal_emit (self, signals[FINISHED], 0);
 }
 
-static bool
-reportd_task_prompt_handle_commit (ReportdDbusTaskPrompt *object,
-                                   GDBusMethodInvocation *invocation,
-                                   gpointer               user_data)
+static void
+reportd_task_on_dispatched (ReportdSchedulerJob *job,
+                            gpointer             user_data)
 {
     ReportdTask *self;
 
     self = REPORTD_TASK (user_data);
 
-    g_object_set_data (G_OBJECT (object), "handled", GINT_TO_POINTER (1));
+    reportd_dbus_task_set_queue_position (self->task_iface, 0);
+    reportd_dbus_task_set_status (self->task_iface, REPORTD_TASK_STATE_RUNNING);
 
-    g_mutex_lock (&self->prompt_mutex);
-    g_cond_signal (&self->prompt_cond);
-    g_mutex_unlock (&self->prompt_mutex);
+    g_message ("Starting task “%s”", self->problem_path);
 
-    return true;
+    reportd_scheduler_run_in_thread (reportd_daemon_get_scheduler (self->daemon),
+                                     reportd_task_pull_thread,
+                                     reportd_task_on_pulled,
+                                     reportd_task_transfer_new (self));
 }
 
-static ReportdDbusTaskPrompt *
-reportd_task_emit_prompt (ReportdTask *self,
-                          const char  *message,
-                          PromptType   type)
+static void
+reportd_task_on_queue_position_changed (ReportdSchedulerJob *job,
+                                        unsigned int         position,
+                                        gpointer             user_data)
 {
-    g_autoptr(GDBusObjectSkeleton) prompt_skeleton = NULL;
-    ReportdDbusTaskPrompt *prompt_interface = NULL;
-    const char *object_path;
+    ReportdTask *self;
+
+    self = REPORTD_TASK (user_data);
+
+    reportd_dbus_task_set_queue_position (self->task_iface, position);
+}
+
+/* The log is kept in memory, sealed against shrinking so that clients can
+ * map it, and handed out through read-only descriptors with offsets of their
+ * own.
+ */
+static bool
+reportd_task_open_log (ReportdTask  *self,
+                       GError      **error)
+{
+    if (-1 != self->log_fd)
+    {
+        return true;
+    }
 
-    prompt_skeleton = g_dbus_object_skeleton_new (REPORTD_DBUS_TASK_PROMPT_PATH);
-    prompt_interface = reportd_dbus_task_prompt_skeleton_new ();
+    self->log_fd = memfd_create ("reportd-task-log", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (-1 == self->log_fd)
+    {
+        g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                     "Failed to create the log: %s", g_strerror (errno));
 
-    g_dbus_object_skeleton_add_interface (prompt_skeleton,
-                                          G_DBUS_INTERFACE_SKELETON (prompt_interface));
+        return false;
+    }
 
-    reportd_daemon_register_object (self->daemon, prompt_skeleton);
+    fcntl (self->log_fd, F_ADD_SEALS, F_SEAL_SHRINK);
 
-    object_path = g_dbus_object_get_object_path (G_DBUS_OBJECT (prompt_skeleton));
+    return true;
+}
 
-    g_signal_connect (prompt_interface, "handle-commit",
-                      G_CALLBACK (reportd_task_prompt_handle_commit), self);
+void
+reportd_task_run_async (ReportdTask         *self,
+                        GAsyncReadyCallback  callback,
+                        gpointer             user_data)
+{
+    ReportdScheduler *scheduler;
+    g_autoptr (GError) error = NULL;
 
-    reportd_dbus_task_emit_prompt (self->task_iface, object_path, message, type);
+    g_return_if_fail (REPORTD_IS_TASK (self));
 
-    g_mutex_lock (&self->prompt_mutex);
+    self->run_task = g_task_new (self, self->cancellable, callback, user_data);
 
-    while (g_object_get_data (G_OBJECT (prompt_interface), "handled") != GINT_TO_POINTER (1))
+    if (!reportd_task_open_log (self, &error))
     {
-        gint64 end_time;
+        g_warning ("Task “%s” will run without a log: %s", self->problem_path, error->message);
+    }
 
-        end_time = g_get_monotonic_time () + 250 * G_TIME_SPAN_MILLISECOND;
+    g_task_set_source_tag (self->run_task, reportd_task_run_async);
+    /* The final status is set before returning, even when canceled. */
+    g_task_set_check_cancellable (self->run_task, false);
 
-        if (g_cancellable_is_cancelled (self->cancellable))
-        {
-            break;
-        }
+    reportd_dbus_task_set_status (self->task_iface, REPORTD_TASK_STATE_QUEUED);
 
-        g_cond_wait_until (&self->prompt_cond, &self->prompt_mutex, end_time);
-    }
+    g_signal_emit (self, signals[STARTED], 0);
+
+    scheduler = reportd_daemon_get_scheduler (self->daemon);
+    self->job = reportd_scheduler_queue (scheduler, self->owner, self->priority,
+                                         reportd_task_on_dispatched,
+                                         reportd_task_on_queue_position_changed,
+                                         self);
+}
 
-    g_mutex_unlock (&self->prompt_mutex);
+bool
+reportd_task_run_finish (ReportdTask   *self,
+                         GAsyncResult  *result,
+                         GError       **error)
+{
+    g_return_val_if_fail (g_task_is_valid (result, self), false);
 
-    g_object_set_data (G_OBJECT (prompt_interface), "handled", NULL);
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
 
-    reportd_daemon_unregister_object (self->daemon, G_DBUS_OBJECT (prompt_skeleton));
+void
+reportd_task_set_priority (ReportdTask              *self,
+                           ReportdSchedulerPriority  priority)
+{
+    g_return_if_fail (REPORTD_IS_TASK (self));
 
-    return prompt_interface;
+    self->priority = priority;
 }
 
-static char *
-reportd_task_ask_callback (const char *msg,
-                           void       *interaction_param)
+void
+reportd_task_cancel (ReportdTask *self)
 {
-    ReportdTask *self;
-    g_autoptr (ReportdDbusTaskPrompt) prompt_interface = NULL;
-    const char *input;
+    g_return_if_fail (REPORTD_IS_TASK (self));
+
+    g_message ("Canceling task “%s”", self->problem_path);
 
-    self = REPORTD_TASK (interaction_param);
-    prompt_interface = reportd_task_emit_prompt (self, msg, ASK);
-    if (g_cancellable_is_cancelled (self->cancellable))
+    g_cancellable_cancel (self->cancellable);
+
+    if (NULL == self->run_task)
     {
-        return NULL;
+        return;
     }
-    input = reportd_dbus_task_prompt_get_input (prompt_interface);
 
-    return g_strdup (input);
-}
+    /* Still waiting for a worker, so there is nothing to interrupt. */
+    if (REPORTD_TASK_STATE_QUEUED == reportd_dbus_task_get_status (self->task_iface))
+    {
+        reportd_task_finish (self, g_error_new_literal (G_IO_ERROR, G_IO_ERROR_CANCELLED,
+                                                        "Operation was cancelled"));
 
-static int
-reportd_task_ask_yes_no_callback (const char *msg,
-                                  void       *interaction_param)
-{
-    ReportdTask *self;
-    g_autoptr (ReportdDbusTaskPrompt) prompt_interface = NULL;
+        return;
+    }
 
-    self = REPORTD_TASK (interaction_param);
-    prompt_interface = reportd_task_emit_prompt (self, msg, ASK_YES_NO);
-    if (g_cancellable_is_cancelled (self->cancellable))
+    if (reportd_task_stop_waiting_for_report (self))
     {
-        return -1;
+        reportd_task_finish (self, g_error_new_literal (G_IO_ERROR, G_IO_ERROR_CANCELLED,
+                                                        "Operation was cancelled"));
+
+        return;
     }
 
-    return reportd_dbus_task_prompt_get_response (prompt_interface);
+    /* Terminating the last running event finishes the task. */
+    for (unsigned int i = 0; NULL != self->events && i < self->events->len; i++)
+    {
+        reportd_task_event_terminate (g_ptr_array_index (self->events, i));
+    }
 }
 
-static int
-reportd_task_ask_yes_no_yesforever_callback (const char *key,
-                                             const char *msg,
-                                             void       *interaction_param)
+static void
+reportd_task_on_finished (GObject      *source_object,
+                          GAsyncResult *res,
+                          gpointer      user_data)
 {
-    const char *value;
     ReportdTask *self;
-    g_autoptr (ReportdDbusTaskPrompt) prompt_interface = NULL;
-    bool response;
-    bool remember;
+    g_autoptr (GError) error = NULL;
+    GDBusMethodInvocation *invocation;
+    int status;
+    const char *message;
 
-    value = libreport_get_user_setting (key);
-    /* The following is replicating the madness inside libreport, where
-     * “no” means “yes, forever”, and “yes” means nothing, really.
-     *
-     * Yes (no?), each implementation has a similar comment.
-     */
-    if (value != NULL && !libreport_string_to_bool(value))
+    self = REPORTD_TASK (source_object);
+    invocation = user_data;
+
+    if (!reportd_task_run_finish (self, res, &error))
     {
-        return TRUE;
+        g_message ("Task %s finished with an error: %s",
+                   self->problem_path, error->message);
     }
-    self = REPORTD_TASK (interaction_param);
-    prompt_interface = reportd_task_emit_prompt (self, msg, ASK_YES_NO_YESFOREVER);
-    if (g_cancellable_is_cancelled (self->cancellable))
+    else
     {
-        return -1;
+        g_message ("Task %s finished successfully", self->problem_path);
     }
-    response = reportd_dbus_task_prompt_get_response (prompt_interface);
-    remember = reportd_dbus_task_prompt_get_remember (prompt_interface);
-    if (remember && !response)
+
+    status = reportd_dbus_task_get_status (self->task_iface);
+    message = NULL != error? error->message : "";
+
+    if (!reportd_task_send_signal (self, "Finished", g_variant_new ("(is)", status, message)))
     {
-        libreport_set_user_setting (key, "no");
+        reportd_dbus_task_emit_finished (self->task_iface, status, message);
     }
 
-    return response;
-}
-
-static int
-reportd_task_ask_yes_no_save_result_callback (const char *key,
-                                              const char *msg,
-                                              void       *interaction_param)
-{
-    const char *value;
-    ReportdTask *self;
-    g_autoptr (ReportdDbusTaskPrompt) prompt_interface = NULL;
-    bool response;
-    bool remember;
+    /* Started with StartAsync, nobody is waiting for a reply. */
+    if (NULL == invocation)
+    {
+        return;
+    }
 
-    value = libreport_get_user_setting (key);
-    if (value != NULL)
+    if (NULL != error)
     {
-        return libreport_string_to_bool (value);
+        g_dbus_method_invocation_return_gerror (invocation, error);
     }
-    self = REPORTD_TASK (interaction_param);
-    prompt_interface = reportd_task_emit_prompt (self, msg, ASK_YES_NO_SAVE);
-    if (g_cancellable_is_cancelled (self->cancellable))
+    else
     {
-        return -1;
+        reportd_dbus_task_complete_start (self->task_iface, invocation);
     }
-    response = reportd_dbus_task_prompt_get_response (prompt_interface);
-    remember = reportd_dbus_task_prompt_get_remember (prompt_interface);
-    if (remember)
+}
+
+static bool
+reportd_task_check_startable (ReportdTask           *self,
+                              GDBusMethodInvocation *invocation)
+{
+    if (NULL != self->run_task)
     {
-        value = response? "yes" : "no";
+        g_dbus_method_invocation_return_error (invocation,
+                                               G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                                               "The task is running already");
 
-        libreport_set_user_setting (key, value);
+        return false;
     }
 
-    return response;
+    return true;
 }
 
-static char *
-reportd_task_ask_password_callback (const char *msg,
-                                    void       *interaction_param)
+static bool
+reportd_task_handle_start (ReportdDbusTask       *object,
+                           GDBusMethodInvocation *invocation,
+                           gpointer               user_data)
 {
     ReportdTask *self;
-    g_autoptr (ReportdDbusTaskPrompt) prompt_interface = NULL;
-    const char *password;
 
-    self = REPORTD_TASK (interaction_param);
-    prompt_interface = reportd_task_emit_prompt (self, msg, ASK_PASSWORD);
-    if (g_cancellable_is_cancelled (self->cancellable))
+    self = REPORTD_TASK (user_data);
+
+    if (reportd_task_check_startable (self, invocation))
     {
-        return NULL;
+        reportd_task_run_async (self, reportd_task_on_finished, invocation);
     }
-    password = reportd_dbus_task_prompt_get_input (prompt_interface);
 
-    return g_strdup (password);
+    return true;
 }
 
-static void
-reportd_task_on_finished (GObject      *source_object,
-                          GAsyncResult *res,
-                          gpointer      user_data)
+static bool
+reportd_task_handle_start_async (ReportdDbusTask       *object,
+                                 GDBusMethodInvocation *invocation,
+                                 gpointer               user_data)
 {
-    GTask *task;
-    gpointer task_data;
     ReportdTask *self;
-    GError *error = NULL;
-    GDBusMethodInvocation *invocation;
-    ReportdDbusTask *proxy;
 
-    task = G_TASK (res);
-    task_data = g_task_get_task_data (task);
-    self = REPORTD_TASK (task_data);
-    invocation = G_DBUS_METHOD_INVOCATION (user_data);
-    proxy = REPORTD_DBUS_TASK (source_object);
-
-    (void) g_task_propagate_boolean (task, &error);
+    self = REPORTD_TASK (user_data);
 
-    if (g_task_had_error (task))
+    if (reportd_task_check_startable (self, invocation))
     {
-        GCancellable *cancellable;
+        reportd_task_run_async (self, reportd_task_on_finished, NULL);
 
-        cancellable = g_task_get_cancellable (task);
+        reportd_dbus_task_complete_start_async (object, invocation);
+    }
 
-        g_message ("Task %s finished with an error: %s",
-                   self->problem_path, error->message);
+    return true;
+}
 
-        if (g_cancellable_is_cancelled (cancellable))
-        {
-            reportd_dbus_task_set_status (proxy, REPORTD_TASK_STATE_CANCELED);
-        }
-        else
-        {
-            reportd_dbus_task_set_status (proxy, REPORTD_TASK_STATE_FAILED);
-        }
+static bool
+reportd_task_handle_set_progress_batching (ReportdDbusTask       *object,
+                                           GDBusMethodInvocation *invocation,
+                                           unsigned int           interval,
+                                           unsigned int           lines,
+                                           gpointer               user_data)
+{
+    ReportdTask *self;
 
-        g_dbus_method_invocation_return_gerror (invocation, error);
+    self = REPORTD_TASK (user_data);
 
-        return;
+    reportd_task_flush_progress (self);
+
+    if (0 == interval && 0 == lines)
+    {
+        g_clear_pointer (&self->progress_batch, g_ptr_array_unref);
+    }
+    else if (NULL == self->progress_batch)
+    {
+        self->progress_batch = g_ptr_array_new_with_free_func (g_free);
     }
 
-    g_message ("Task %s finished successfully", self->problem_path);
+    self->progress_interval = interval;
+    self->progress_lines = lines;
 
-    reportd_dbus_task_set_status (proxy, REPORTD_TASK_STATE_COMPLETED);
+    reportd_dbus_task_complete_set_progress_batching (object, invocation);
 
-    reportd_dbus_task_complete_start (proxy, invocation);
+    return true;
 }
 
-static void
-reportd_task_start (GTask        *task,
-                    gpointer      source_object,
-                    gpointer      task_data,
-                    GCancellable *cancellable)
+static bool
+reportd_task_handle_get_log_stream (ReportdDbusTask       *object,
+                                    GDBusMethodInvocation *invocation,
+                                    GUnixFDList           *fd_list,
+                                    gpointer               user_data)
 {
     ReportdTask *self;
-    const char *workflow_name;
-    char *workflow_env;
-    GError *error = NULL;
-    g_autofree char *problem_directory = NULL;
-    GList *event_names;
+    g_autofree char *path = NULL;
+    g_autoptr (GUnixFDList) out_fd_list = NULL;
+    g_autoptr (GError) error = NULL;
+    int fd;
+
+    self = REPORTD_TASK (user_data);
 
-    self = REPORTD_TASK (task_data);
-    workflow_name = wf_get_name (self->workflow);
-    workflow_env = g_strdup_printf ("LIBREPORT_WORKFLOW=%s", workflow_name);
-    problem_directory = reportd_daemon_get_problem_directory (self->daemon,
-                                                              self->problem_path,
-                                                              &error);
-    if (NULL == problem_directory)
+    if (!reportd_task_open_log (self, &error))
     {
-        g_task_return_error (task, error);
+        g_dbus_method_invocation_return_gerror (invocation, error);
 
-        return;
+        return true;
     }
-    event_names = wf_get_event_names (self->workflow);
 
-    self->run_state = new_run_event_state ();
-
-    self->run_state->logging_callback = do_log2;
-    self->run_state->logging_param = self;
-    self->run_state->error_callback = reportd_task_error_callback;
-    self->run_state->error_param = self;
-    self->run_state->interaction_param = self;
-    self->run_state->ask_callback = reportd_task_ask_callback;
-    self->run_state->ask_yes_no_callback = reportd_task_ask_yes_no_callback;
-    self->run_state->ask_yes_no_yesforever_callback = reportd_task_ask_yes_no_yesforever_callback;
-    self->run_state->ask_yes_no_save_result_callback = reportd_task_ask_yes_no_save_result_callback;
-    self->run_state->ask_password_callback = reportd_task_ask_password_callback;
+    path = g_strdup_printf ("/proc/self/fd/%d", self->log_fd);
+    fd = open (path, O_RDONLY | O_CLOEXEC);
+    if (-1 == fd)
+    {
+        g_dbus_method_invocation_return_error (invocation,
+                                               G_IO_ERROR, g_io_error_from_errno (errno),
+                                               "Failed to open the log: %s",
+                                               g_strerror (errno));
 
-    g_ptr_array_add (self->run_state->extra_environment, workflow_env);
+        return true;
+    }
 
-    g_message ("Starting task “%s”", self->problem_path);
+    out_fd_list = g_unix_fd_list_new ();
 
-    if (g_task_return_error_if_cancelled (task))
+    if (g_unix_fd_list_append (out_fd_list, fd, &error) == -1)
     {
-        goto cleanup;
+        close (fd);
+
+        g_dbus_method_invocation_return_gerror (invocation, error);
+
+        return true;
     }
 
-    reportd_dbus_task_set_status (self->task_iface, REPORTD_TASK_STATE_RUNNING);
+    close (fd);
 
-    if (!reportd_task_run_event_chain (self, problem_directory, event_names, &error))
-    {
-        g_task_return_error (task, error);
+    reportd_dbus_task_complete_get_log_stream (object, invocation, out_fd_list,
+                                               g_variant_new_handle (0));
 
-        goto cleanup;
-    }
+    return true;
+}
+
+static void
+reportd_task_on_subscriber_vanished (GDBusConnection *connection,
+                                     const char      *name,
+                                     gpointer         user_data)
+{
+    GHashTable *subscribers;
 
-    if (g_task_return_error_if_cancelled (task))
+    subscribers = user_data;
+
+    g_hash_table_remove (subscribers, name);
+}
+
+static void
+reportd_task_unwatch_subscriber (gpointer data)
+{
+    g_bus_unwatch_name (GPOINTER_TO_UINT (data));
+}
+
+/* Unique bus names of subscribers, each watched for as long as it is in the
+ * table.
+ */
+GHashTable *
+reportd_task_subscribers_new (void)
+{
+    return g_hash_table_new_full (g_str_hash, g_str_equal,
+                                  g_free, reportd_task_unwatch_subscriber);
+}
+
+void
+reportd_task_subscribe_caller (GHashTable            *subscribers,
+                               GDBusMethodInvocation *invocation)
+{
+    const char *sender;
+    unsigned int watcher_id;
+
+    sender = g_dbus_method_invocation_get_sender (invocation);
+    if (NULL == sender || g_hash_table_contains (subscribers, sender))
     {
-        goto cleanup;
+        return;
     }
 
-    g_clear_error (&error);
+    watcher_id = g_bus_watch_name_on_connection (g_dbus_method_invocation_get_connection (invocation),
+                                                 sender,
+                                                 G_BUS_NAME_WATCHER_FLAGS_NONE,
+                                                 NULL,
+                                                 reportd_task_on_subscriber_vanished,
+                                                 subscribers,
+                                                 NULL);
 
-    if (!reportd_daemon_push_problem_directory (self->daemon, problem_directory, &error))
-    {
-        g_task_return_error (task, error);
+    g_hash_table_insert (subscribers, g_strdup (sender), GUINT_TO_POINTER (watcher_id));
+}
 
-        goto cleanup;
-    }
+static bool
+reportd_task_handle_subscribe (ReportdDbusTask       *object,
+                               GDBusMethodInvocation *invocation,
+                               gpointer               user_data)
+{
+    ReportdTask *self;
+
+    self = REPORTD_TASK (user_data);
+
+    reportd_task_subscribe_caller (self->subscribers, invocation);
 
-    g_task_return_boolean (task, true);
+    reportd_dbus_task_complete_subscribe (object, invocation);
 
-cleanup:
-    g_clear_pointer (&self->run_state, free_run_event_state);
-    g_list_free_full (event_names, g_free);
+    return true;
 }
 
 static bool
-reportd_task_handle_start (ReportdDbusTask       *object,
-                           GDBusMethodInvocation *invocation,
-                           gpointer               user_data)
+reportd_task_handle_unsubscribe (ReportdDbusTask       *object,
+                                 GDBusMethodInvocation *invocation,
+                                 gpointer               user_data)
 {
     ReportdTask *self;
-    g_autoptr (GTask) task = NULL;
-    g_autoptr (GThread) thread = NULL;
 
     self = REPORTD_TASK (user_data);
-    task = g_task_new (object, self->cancellable, reportd_task_on_finished, invocation);
 
-    g_task_set_task_data (task, user_data, NULL);
+    g_hash_table_remove (self->subscribers, g_dbus_method_invocation_get_sender (invocation));
 
-    g_task_run_in_thread (task, reportd_task_start);
+    reportd_dbus_task_complete_unsubscribe (object, invocation);
 
     return true;
 }
@@ -540,14 +2975,7 @@ reportd_task_handle_cancel (ReportdDbusTask       *object,
 
     self = REPORTD_TASK (user_data);
 
-    g_message ("Canceling task “%s”", self->problem_path);
-
-    g_cancellable_cancel (self->cancellable);
-
-    if (self->run_state->command_pid > 0)
-    {
-        kill (-self->run_state->command_pid, SIGTERM);
-    }
+    reportd_task_cancel (self);
 
     reportd_dbus_task_complete_cancel (object, invocation);
 
@@ -559,14 +2987,26 @@ reportd_task_init (ReportdTask *self)
 {
     self->task_iface = reportd_dbus_task_skeleton_new ();
     self->cancellable = g_cancellable_new ();
+    self->log_fd = -1;
+    g_queue_init (&self->prompt_queue);
+    self->subscribers = reportd_task_subscribers_new ();
 
-    g_cond_init (&self->prompt_cond);
-    g_mutex_init (&self->prompt_mutex);
-
+    g_signal_connect (self->task_iface, "g-authorize-method",
+                      G_CALLBACK (reportd_task_on_authorize_method), self);
     g_signal_connect (self->task_iface, "handle-start",
                       G_CALLBACK (reportd_task_handle_start), self);
+    g_signal_connect (self->task_iface, "handle-start-async",
+                      G_CALLBACK (reportd_task_handle_start_async), self);
     g_signal_connect (self->task_iface, "handle-cancel",
                       G_CALLBACK (reportd_task_handle_cancel), self);
+    g_signal_connect (self->task_iface, "handle-set-progress-batching",
+                      G_CALLBACK (reportd_task_handle_set_progress_batching), self);
+    g_signal_connect (self->task_iface, "handle-get-log-stream",
+                      G_CALLBACK (reportd_task_handle_get_log_stream), self);
+    g_signal_connect (self->task_iface, "handle-subscribe",
+                      G_CALLBACK (reportd_task_handle_subscribe), self);
+    g_signal_connect (self->task_iface, "handle-unsubscribe",
+                      G_CALLBACK (reportd_task_handle_unsubscribe), self);
 
     g_dbus_object_skeleton_add_interface (G_DBUS_OBJECT_SKELETON (self),
                                           G_DBUS_INTERFACE_SKELETON (self->task_iface));
@@ -594,15 +3034,31 @@ reportd_task_set_property (GObject      *object,
         }
         break;
 
+        case PROP_CONNECTION:
+        {
+            GDBusConnection *connection;
+
+            connection = g_value_get_object (value);
+
+            g_set_object (&self->connection, connection);
+        }
+        break;
+
+        case PROP_OWNER:
+        {
+            self->owner = g_value_dup_string (value);
+        }
+        break;
+
         case PROP_PROBLEM_PATH:
         {
             self->problem_path = g_value_dup_string (value);
         }
         break;
 
-        case PROP_WORKFLOW:
+        case PROP_CONTEXT:
         {
-            self->workflow = g_value_get_pointer (value);
+            self->context = g_value_dup_boxed (value);
         }
         break;
 
@@ -631,15 +3087,27 @@ reportd_task_get_property (GObject      *object,
         }
         break;
 
+        case PROP_CONNECTION:
+        {
+            g_value_set_object (value, self->connection);
+        }
+        break;
+
+        case PROP_OWNER:
+        {
+            g_value_set_string (value, self->owner);
+        }
+        break;
+
         case PROP_PROBLEM_PATH:
         {
             g_value_set_string (value, self->problem_path);
         }
         break;
 
-        case PROP_WORKFLOW:
+        case PROP_CONTEXT:
         {
-            g_value_set_pointer (value, self->workflow);
+            g_value_set_boxed (value, self->context);
         }
         break;
 
@@ -659,7 +3127,6 @@ reportd_task_constructed (GObject *object)
 
     G_OBJECT_CLASS (reportd_task_parent_class)->constructed (object);
 
-    reportd_daemon_register_object (self->daemon, G_DBUS_OBJECT_SKELETON (self));
     reportd_dbus_task_set_status (self->task_iface, REPORTD_TASK_STATE_READY);
 }
 
@@ -670,7 +3137,18 @@ reportd_task_dispose (GObject *object)
 
     self = REPORTD_TASK (object);
 
+    g_clear_handle_id (&self->progress_source_id, g_source_remove);
+    g_clear_pointer (&self->subscribers, g_hash_table_destroy);
+    if (NULL != self->prompt_skeleton)
+    {
+        g_signal_handlers_disconnect_by_data (self->prompt_iface, self);
+
+        reportd_daemon_unregister_object (self->daemon, G_DBUS_OBJECT (self->prompt_skeleton));
+    }
+    g_clear_object (&self->prompt_iface);
+    g_clear_object (&self->prompt_skeleton);
     g_clear_object (&self->cancellable);
+    g_clear_object (&self->connection);
     g_clear_object (&self->daemon);
 
     G_OBJECT_CLASS (reportd_task_parent_class)->dispose (object);
@@ -684,8 +3162,14 @@ reportd_task_finalize (GObject *object)
     self = REPORTD_TASK (object);
 
     g_clear_pointer (&self->problem_path, g_free);
-    g_cond_clear (&self->prompt_cond);
-    g_mutex_clear (&self->prompt_mutex);
+    g_clear_pointer (&self->owner, g_free);
+    g_clear_pointer (&self->context, reportd_task_context_unref);
+    g_clear_pointer (&self->progress_batch, g_ptr_array_unref);
+
+    if (-1 != self->log_fd)
+    {
+        close (self->log_fd);
+    }
 
     G_OBJECT_CLASS (reportd_task_parent_class)->finalize (object);
 }
@@ -707,6 +3191,18 @@ reportd_task_class_init (ReportdTaskClass *klass)
                                                    (G_PARAM_READWRITE |
                                                     G_PARAM_CONSTRUCT_ONLY |
                                                     G_PARAM_STATIC_STRINGS));
+    properties[PROP_CONNECTION] = g_param_spec_object ("connection", "Connection",
+                                                       "The connection the task is exported on",
+                                                       G_TYPE_DBUS_CONNECTION,
+                                                       (G_PARAM_READWRITE |
+                                                        G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+    properties[PROP_OWNER] = g_param_spec_string ("owner", "Owner",
+                                                  "Unique bus name of the client that created the task",
+                                                  NULL,
+                                                  (G_PARAM_READWRITE |
+                                                   G_PARAM_CONSTRUCT_ONLY |
+                                                   G_PARAM_STATIC_STRINGS));
     properties[PROP_PROBLEM_PATH] = g_param_spec_string ("problem-path",
                                                          "Problem Path",
                                                          "Object path to the problem on the message bus",
@@ -714,25 +3210,41 @@ reportd_task_class_init (ReportdTaskClass *klass)
                                                          (G_PARAM_READWRITE |
                                                           G_PARAM_CONSTRUCT_ONLY |
                                                           G_PARAM_STATIC_STRINGS));
-    properties[PROP_WORKFLOW] = g_param_spec_pointer ("workflow", "Workflow",
-                                                      "The workflow object for this task",
-                                                      (G_PARAM_READWRITE |
-                                                       G_PARAM_CONSTRUCT_ONLY |
-                                                       G_PARAM_STATIC_STRINGS));
+    properties[PROP_CONTEXT] = g_param_spec_boxed ("context", "Context",
+                                                   "The execution context shared by tasks running the same workflow",
+                                                   REPORTD_TYPE_TASK_CONTEXT,
+                                                   (G_PARAM_READWRITE |
+                                                    G_PARAM_CONSTRUCT_ONLY |
+                                                    G_PARAM_STATIC_STRINGS));
 
     g_object_class_install_properties (object_class, N_PROPERTIES, properties);
+
+    signals[STARTED] = g_signal_new ("started",
+                                     G_TYPE_FROM_CLASS (klass),
+                                     G_SIGNAL_RUN_LAST,
+                                     0, NULL, NULL, NULL,
+                                     G_TYPE_NONE, 0);
+    signals[FINISHED] = g_signal_new ("finished",
+                                      G_TYPE_FROM_CLASS (klass),
+                                      G_SIGNAL_RUN_LAST,
+                                      0, NULL, NULL, NULL,
+                                      G_TYPE_NONE, 0);
 }
 
 ReportdTask *
-reportd_task_new (ReportdDaemon *daemon,
-                  const char    *object_path,
-                  const char    *problem_path,
-                  workflow_t    *workflow)
+reportd_task_new (ReportdDaemon      *daemon,
+                  GDBusConnection    *connection,
+                  const char         *owner,
+                  const char         *object_path,
+                  const char         *problem_path,
+                  ReportdTaskContext *context)
 {
     return g_object_new (REPORTD_TYPE_TASK,
                          "daemon", daemon,
+                         "connection", connection,
+                         "owner", owner,
                          "g-object-path", object_path,
                          "problem-path", problem_path,
-                         "workflow", workflow,
+                         "context", context,
                          NULL);
 }
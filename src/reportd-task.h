@@ -14,11 +14,13 @@
 
 #pragma once
 
+#include "reportd-scheduler.h"
+#include "reportd-task-context.h"
 #include "reportd-types.h"
 
-#include <gio/gio.h>
+#include <stdbool.h>
 
-#include <workflow.h>
+#include <gio/gio.h>
 
 G_BEGIN_DECLS
 
@@ -30,13 +32,50 @@ G_DECLARE_FINAL_TYPE (ReportdTask, reportd_task, REPORTD, TASK, GDBusObjectSkele
 typedef enum
 {
     REPORTD_TASK_ERROR_EVENT_HANDLER_FAILED,
+    REPORTD_TASK_ERROR_TIMED_OUT,
+    REPORTD_TASK_ERROR_UNANSWERED,
 } ReportdTaskError;
 
+typedef enum
+{
+    REPORTD_TASK_STATE_READY,
+    REPORTD_TASK_STATE_RUNNING,
+    REPORTD_TASK_STATE_COMPLETED,
+    REPORTD_TASK_STATE_FAILED,
+    REPORTD_TASK_STATE_CANCELED,
+    REPORTD_TASK_STATE_QUEUED,
+} ReportdTaskState;
+
 GQuark reportd_task_error_quark (void);
 
-ReportdTask *reportd_task_new (ReportdDaemon   *daemon,
-                               const char      *object_path,
-                               const char      *problem_path,
-                               struct workflow *workflow);
+bool         reportd_task_authorize_caller (GDBusMethodInvocation  *invocation,
+                                            const char             *owner);
+
+GHashTable  *reportd_task_subscribers_new  (void);
+void         reportd_task_subscribe_caller (GHashTable             *subscribers,
+                                            GDBusMethodInvocation  *invocation);
+bool         reportd_task_send_signal_to_watchers (GDBusInterfaceSkeleton *skeleton,
+                                                   const char             *owner,
+                                                   GHashTable             *subscribers,
+                                                   const char             *signal_name,
+                                                   GVariant               *parameters);
+
+void         reportd_task_run_async  (ReportdTask          *task,
+                                      GAsyncReadyCallback   callback,
+                                      gpointer              user_data);
+bool         reportd_task_run_finish (ReportdTask          *task,
+                                      GAsyncResult         *result,
+                                      GError              **error);
+void         reportd_task_cancel     (ReportdTask          *task);
+
+void         reportd_task_set_priority (ReportdTask              *task,
+                                        ReportdSchedulerPriority  priority);
+
+ReportdTask *reportd_task_new        (ReportdDaemon        *daemon,
+                                      GDBusConnection      *connection,
+                                      const char           *owner,
+                                      const char           *object_path,
+                                      const char           *problem_path,
+                                      ReportdTaskContext   *context);
 
 G_END_DECLS
@@ -0,0 +1,353 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#include "reportd-workflow-plan.h"
+
+#include <event_config.h>
+
+typedef struct
+{
+    char *name;
+    /* LIBREPORT_WORKFLOW and the event configuration, as VAR=value */
+    GStrv environment;
+    /* Seconds the event may take, 0 for no limit */
+    unsigned int timeout;
+    ReportdEventPriority priority;
+    /* Whether the results can be reused, and what they follow from */
+    bool pure;
+    GStrv reads;
+    GStrv writes;
+    /* Number of events that have to finish before this one can start */
+    unsigned int blockers;
+    /* Indices of the events waiting on this one */
+    GArray *dependents;
+    /* Exit code of the handlers to be taken for another, -1 if none */
+    int quirk_code;
+    int quirk_mapping;
+} ReportdWorkflowPlanEvent;
+
+struct _ReportdWorkflowPlan
+{
+    int ref_count;
+
+    char *workflow_name;
+    /* Seconds running all the events may take, 0 for no limit */
+    unsigned int timeout;
+    /* Duplicates of a problem are reported only once */
+    bool deduplicate;
+    GArray *events;
+};
+
+G_DEFINE_BOXED_TYPE (ReportdWorkflowPlan, reportd_workflow_plan,
+                     reportd_workflow_plan_ref, reportd_workflow_plan_unref)
+
+static const struct
+{
+    const char *event_name;
+    int quirk_code;
+    int quirk_mapping;
+} quirks[] =
+{
+    /* For some reason, abrt-action-ureport exits if it detects a
+     * Bugzilla report…
+     */
+    { "report_uReport", 70, 0 },
+};
+
+static void
+reportd_workflow_plan_event_clear (ReportdWorkflowPlanEvent *event)
+{
+    g_free (event->name);
+    g_strfreev (event->environment);
+    g_strfreev (event->reads);
+    g_strfreev (event->writes);
+    g_array_unref (event->dependents);
+}
+
+static GStrv
+reportd_workflow_plan_build_environment (const char *workflow_name,
+                                         const char *event_name)
+{
+    g_autoptr (GPtrArray) environment = NULL;
+    event_config_t *config;
+
+    environment = g_ptr_array_new_with_free_func (g_free);
+
+    g_ptr_array_add (environment, g_strdup_printf ("LIBREPORT_WORKFLOW=%s", workflow_name));
+
+    config = get_event_config (event_name);
+    if (NULL != config)
+    {
+        for (GList *l = config->options; NULL != l; l = l->next)
+        {
+            event_option_t *option;
+
+            option = l->data;
+            if (NULL == option->eo_value)
+            {
+                continue;
+            }
+
+            g_ptr_array_add (environment,
+                             g_strdup_printf ("%s=%s", option->eo_name, option->eo_value));
+        }
+    }
+
+    g_ptr_array_add (environment, NULL);
+
+    return (GStrv) g_ptr_array_free (g_steal_pointer (&environment), FALSE);
+}
+
+static ReportdWorkflowPlanEvent *
+reportd_workflow_plan_get_event (ReportdWorkflowPlan *self,
+                                 unsigned int         event)
+{
+    g_return_val_if_fail (NULL != self, NULL);
+    g_return_val_if_fail (event < self->events->len, NULL);
+
+    return &g_array_index (self->events, ReportdWorkflowPlanEvent, event);
+}
+
+const char *
+reportd_workflow_plan_get_workflow_name (ReportdWorkflowPlan *self)
+{
+    g_return_val_if_fail (NULL != self, NULL);
+
+    return self->workflow_name;
+}
+
+unsigned int
+reportd_workflow_plan_get_timeout (ReportdWorkflowPlan *self)
+{
+    g_return_val_if_fail (NULL != self, 0);
+
+    return self->timeout;
+}
+
+bool
+reportd_workflow_plan_get_deduplicate (ReportdWorkflowPlan *self)
+{
+    g_return_val_if_fail (NULL != self, false);
+
+    return self->deduplicate;
+}
+
+unsigned int
+reportd_workflow_plan_get_n_events (ReportdWorkflowPlan *self)
+{
+    g_return_val_if_fail (NULL != self, 0);
+
+    return self->events->len;
+}
+
+const char *
+reportd_workflow_plan_get_event_name (ReportdWorkflowPlan *self,
+                                      unsigned int         event)
+{
+    return reportd_workflow_plan_get_event (self, event)->name;
+}
+
+const char * const *
+reportd_workflow_plan_get_event_environment (ReportdWorkflowPlan *self,
+                                             unsigned int         event)
+{
+    return (const char * const *) reportd_workflow_plan_get_event (self, event)->environment;
+}
+
+bool
+reportd_workflow_plan_get_event_pure (ReportdWorkflowPlan *self,
+                                      unsigned int         event)
+{
+    return reportd_workflow_plan_get_event (self, event)->pure;
+}
+
+/* NULL if the event configuration does not say. */
+const char * const *
+reportd_workflow_plan_get_event_reads (ReportdWorkflowPlan *self,
+                                       unsigned int         event)
+{
+    return (const char * const *) reportd_workflow_plan_get_event (self, event)->reads;
+}
+
+const char * const *
+reportd_workflow_plan_get_event_writes (ReportdWorkflowPlan *self,
+                                        unsigned int         event)
+{
+    return (const char * const *) reportd_workflow_plan_get_event (self, event)->writes;
+}
+
+unsigned int
+reportd_workflow_plan_get_event_timeout (ReportdWorkflowPlan *self,
+                                         unsigned int         event)
+{
+    return reportd_workflow_plan_get_event (self, event)->timeout;
+}
+
+const ReportdEventPriority *
+reportd_workflow_plan_get_event_priority (ReportdWorkflowPlan *self,
+                                          unsigned int         event)
+{
+    return &reportd_workflow_plan_get_event (self, event)->priority;
+}
+
+unsigned int
+reportd_workflow_plan_get_event_blockers (ReportdWorkflowPlan *self,
+                                          unsigned int         event)
+{
+    return reportd_workflow_plan_get_event (self, event)->blockers;
+}
+
+const unsigned int *
+reportd_workflow_plan_get_event_dependents (ReportdWorkflowPlan *self,
+                                            unsigned int         event,
+                                            unsigned int        *n_dependents)
+{
+    ReportdWorkflowPlanEvent *plan_event;
+
+    plan_event = reportd_workflow_plan_get_event (self, event);
+
+    *n_dependents = plan_event->dependents->len;
+
+    return (const unsigned int *) (void *) plan_event->dependents->data;
+}
+
+int
+reportd_workflow_plan_map_exit_code (ReportdWorkflowPlan *self,
+                                     unsigned int         event,
+                                     int                  exit_code)
+{
+    ReportdWorkflowPlanEvent *plan_event;
+
+    plan_event = reportd_workflow_plan_get_event (self, event);
+
+    if (-1 != plan_event->quirk_code && plan_event->quirk_code == exit_code)
+    {
+        g_message ("Correcting quirk: event “%s” exited with code %d; replacing with %d",
+                   plan_event->name, exit_code, plan_event->quirk_mapping);
+
+        return plan_event->quirk_mapping;
+    }
+
+    return exit_code;
+}
+
+ReportdWorkflowPlan *
+reportd_workflow_plan_ref (ReportdWorkflowPlan *self)
+{
+    g_return_val_if_fail (NULL != self, NULL);
+
+    g_atomic_int_inc (&self->ref_count);
+
+    return self;
+}
+
+void
+reportd_workflow_plan_unref (ReportdWorkflowPlan *self)
+{
+    g_return_if_fail (NULL != self);
+
+    if (!g_atomic_int_dec_and_test (&self->ref_count))
+    {
+        return;
+    }
+
+    g_array_unref (self->events);
+    g_free (self->workflow_name);
+
+    g_free (self);
+}
+
+/* Works out which events have to wait for which, from the ordering and the
+ * problem elements declared in the event configuration. Events without any
+ * configuration keep to the workflow order.
+ */
+ReportdWorkflowPlan *
+reportd_workflow_plan_new (workflow_t           *workflow,
+                           ReportdEventRegistry *registry)
+{
+    ReportdWorkflowPlan *self;
+    GList *event_names;
+
+    g_return_val_if_fail (NULL != workflow, NULL);
+    g_return_val_if_fail (REPORTD_IS_EVENT_REGISTRY (registry), NULL);
+
+    self = g_new0 (ReportdWorkflowPlan, 1);
+
+    self->ref_count = 1;
+    self->workflow_name = g_strdup (wf_get_name (workflow));
+    self->timeout = reportd_event_registry_get_workflow_timeout (registry, self->workflow_name);
+    self->deduplicate = reportd_event_registry_get_workflow_deduplicate (registry, self->workflow_name);
+    self->events = g_array_new (FALSE, TRUE, sizeof (ReportdWorkflowPlanEvent));
+
+    g_array_set_clear_func (self->events, (GDestroyNotify) reportd_workflow_plan_event_clear);
+
+    event_names = wf_get_event_names (workflow);
+
+    for (GList *l = event_names; NULL != l; l = l->next)
+    {
+        ReportdWorkflowPlanEvent event = { 0, };
+        const ReportdEventInfo *info;
+        unsigned int index;
+
+        index = self->events->len;
+
+        event.name = g_strdup (l->data);
+        event.environment = reportd_workflow_plan_build_environment (self->workflow_name,
+                                                                     event.name);
+        event.dependents = g_array_new (FALSE, FALSE, sizeof (unsigned int));
+        event.quirk_code = -1;
+
+        reportd_event_priority_init_default (&event.priority, event.name);
+
+        for (int i = 0; i < G_N_ELEMENTS (quirks); i++)
+        {
+            if (g_strcmp0 (quirks[i].event_name, event.name) == 0)
+            {
+                event.quirk_code = quirks[i].quirk_code;
+                event.quirk_mapping = quirks[i].quirk_mapping;
+            }
+        }
+
+        info = reportd_event_registry_lookup (registry, event.name);
+        if (NULL != info)
+        {
+            event.priority = info->priority;
+            event.timeout = info->timeout;
+            event.pure = info->pure;
+            event.reads = g_strdupv (info->reads);
+            event.writes = g_strdupv (info->writes);
+        }
+
+        for (unsigned int i = 0; i < index; i++)
+        {
+            ReportdWorkflowPlanEvent *earlier;
+
+            earlier = &g_array_index (self->events, ReportdWorkflowPlanEvent, i);
+
+            if (reportd_event_info_depends_on (info, earlier->name,
+                                               reportd_event_registry_lookup (registry, earlier->name)))
+            {
+                g_array_append_val (earlier->dependents, index);
+
+                event.blockers++;
+            }
+        }
+
+        g_array_append_val (self->events, event);
+    }
+
+    g_list_free_full (event_names, g_free);
+
+    return self;
+}
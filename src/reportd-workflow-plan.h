@@ -0,0 +1,72 @@
+/* reportd -- Software problem reporting service
+ *
+ * Copyright 2016 Red Hat Inc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ *
+ * Author: Jakub Filak <jfilak@redhat.com>
+ */
+
+#pragma once
+
+#include "reportd-event-registry.h"
+
+#include <gio/gio.h>
+
+#include <workflow.h>
+
+G_BEGIN_DECLS
+
+#define REPORTD_TYPE_WORKFLOW_PLAN reportd_workflow_plan_get_type ()
+
+/* Everything about running a workflow that does not depend on the problem:
+ * the events, the order they have to run in, the environment of their
+ * handlers, how long they may take and how much of the machine they get.
+ * Plans are immutable once built and shared by all tasks running the
+ * workflow.
+ */
+typedef struct _ReportdWorkflowPlan ReportdWorkflowPlan;
+
+GType                reportd_workflow_plan_get_type                 (void);
+
+const char          *reportd_workflow_plan_get_workflow_name        (ReportdWorkflowPlan *plan);
+unsigned int         reportd_workflow_plan_get_timeout              (ReportdWorkflowPlan *plan);
+bool                 reportd_workflow_plan_get_deduplicate          (ReportdWorkflowPlan *plan);
+unsigned int         reportd_workflow_plan_get_n_events             (ReportdWorkflowPlan *plan);
+const char          *reportd_workflow_plan_get_event_name           (ReportdWorkflowPlan *plan,
+                                                                     unsigned int         event);
+const char * const  *reportd_workflow_plan_get_event_environment    (ReportdWorkflowPlan *plan,
+                                                                     unsigned int         event);
+bool                 reportd_workflow_plan_get_event_pure           (ReportdWorkflowPlan *plan,
+                                                                     unsigned int         event);
+const char * const  *reportd_workflow_plan_get_event_reads          (ReportdWorkflowPlan *plan,
+                                                                     unsigned int         event);
+const char * const  *reportd_workflow_plan_get_event_writes         (ReportdWorkflowPlan *plan,
+                                                                     unsigned int         event);
+unsigned int         reportd_workflow_plan_get_event_timeout        (ReportdWorkflowPlan *plan,
+                                                                     unsigned int         event);
+const ReportdEventPriority *reportd_workflow_plan_get_event_priority (ReportdWorkflowPlan *plan,
+                                                                     unsigned int         event);
+unsigned int         reportd_workflow_plan_get_event_blockers       (ReportdWorkflowPlan *plan,
+                                                                     unsigned int         event);
+const unsigned int  *reportd_workflow_plan_get_event_dependents     (ReportdWorkflowPlan *plan,
+                                                                     unsigned int         event,
+                                                                     unsigned int        *n_dependents);
+int                  reportd_workflow_plan_map_exit_code            (ReportdWorkflowPlan *plan,
+                                                                     unsigned int         event,
+                                                                     int                  exit_code);
+
+ReportdWorkflowPlan *reportd_workflow_plan_ref                      (ReportdWorkflowPlan *plan);
+void                 reportd_workflow_plan_unref                    (ReportdWorkflowPlan *plan);
+
+ReportdWorkflowPlan *reportd_workflow_plan_new                      (struct workflow      *workflow,
+                                                                     ReportdEventRegistry *registry);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (ReportdWorkflowPlan, reportd_workflow_plan_unref)
+
+G_END_DECLS
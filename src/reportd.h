@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include "reportd-batch-task.h"
 #include "reportd-daemon.h"
 #include "reportd-service.h"
 #include "reportd-task.h"
@@ -23,3 +24,4 @@
 #define REPORTD_DBUS_SERVICE_PATH        "/org/freedesktop/reportd/Service"
 #define REPORTD_DBUS_TASK_PATH           "/org/freedesktop/reportd/Task"
 #define REPORTD_DBUS_TASK_PROMPT_PATH    REPORTD_DBUS_TASK_PATH "/Prompt"
+#define REPORTD_DBUS_BATCH_TASK_PATH     "/org/freedesktop/reportd/BatchTask"
@@ -0,0 +1,167 @@
+# Proxies for the Problems2 and reportd D-Bus objects, shared by the scripts
+# in this directory.
+#
+# The scripts need python3-dbus, python3-gobject and a running reportd and
+# Problems2 service. When any of that is missing, they exit with 77 for meson
+# to count them as skipped.
+
+import sys
+
+try:
+    import dbus
+    import dbus.mainloop.glib
+
+    from gi.repository import GLib
+except ImportError as error:
+    print("Skipping, D-Bus bindings are not available: {0}".format(error))
+    sys.exit(77)
+
+PROMPT_ASK = 0
+PROMPT_ASK_PASSWORD = 4
+
+
+class DBusObject(object):
+
+    def __init__(self, bus, address, obj_path, interface):
+        obj_proxy = bus.get_object(address, obj_path)
+
+        self._properties = dbus.Interface(
+                            obj_proxy,
+                            dbus_interface="org.freedesktop.DBus.Properties")
+
+        self._interface = interface
+        self._obj = dbus.Interface(obj_proxy, dbus_interface=interface)
+
+    def __getattribute__(self, name):
+        try:
+            return object.__getattribute__(self, name)
+        except AttributeError:
+            obj = object.__getattribute__(self, "_obj")
+            return obj.get_dbus_method(name)
+
+    def getobject(self):
+        return object.__getattribute__(self, "_obj")
+
+    def getobjectproperties(self):
+        return object.__getattribute__(self, "_properties")
+
+    def getproperty(self, name):
+        properties = object.__getattribute__(self, "_properties")
+        interface = object.__getattribute__(self, "_interface")
+        return properties.Get(interface, name)
+
+    def setproperty(self, name, value):
+        properties = object.__getattribute__(self, "_properties")
+        interface = object.__getattribute__(self, "_interface")
+        properties.Set(interface, name, value)
+
+
+class Problems2Object(DBusObject):
+
+    def __init__(self, bus, path, iface):
+        super(Problems2Object, self).__init__(
+                                        bus,
+                                        "org.freedesktop.problems",
+                                        path,
+                                        iface)
+
+
+class Problems2Service(Problems2Object):
+
+    def __init__(self, bus, path="/org/freedesktop/Problems2"):
+        super(Problems2Service, self).__init__(
+                                        bus,
+                                        path,
+                                        "org.freedesktop.Problems2")
+
+
+class Problems2Entry(Problems2Object):
+
+    def __init__(self, bus, path):
+        super(Problems2Entry, self).__init__(
+                                        bus,
+                                        path,
+                                        "org.freedesktop.Problems2.Entry")
+
+
+class Problems2Session(Problems2Object):
+
+    def __init__(self, bus, path):
+        super(Problems2Session, self).__init__(
+                                        bus,
+                                        path,
+                                        "org.freedesktop.Problems2.Session")
+
+
+class Problems2Task(Problems2Object):
+
+    def __init__(self, bus, path):
+        super(Problems2Task, self).__init__(
+                                        bus,
+                                        path,
+                                        "org.freedesktop.Problems2.Task")
+
+
+class ReportdObject(DBusObject):
+
+    def __init__(self, bus, path, iface):
+        super(ReportdObject, self).__init__(
+                                        bus,
+                                        "org.freedesktop.reportd",
+                                        path,
+                                        iface)
+
+
+class ReportdService(ReportdObject):
+
+    def __init__(self, bus):
+        super(ReportdService, self).__init__(
+                                        bus,
+                                        "/org/freedesktop/reportd/Service",
+                                        "org.freedesktop.reportd.Service")
+
+
+class ReportdTask(ReportdObject):
+
+    def __init__(self, bus, path):
+        super(ReportdTask, self).__init__(
+                                        bus,
+                                        path,
+                                        "org.freedesktop.reportd.Task")
+
+
+class ReportdTaskPrompt(ReportdObject):
+
+    def __init__(self, bus, path):
+        super(ReportdTaskPrompt, self).__init__(
+                                        bus,
+                                        path,
+                                        "org.freedesktop.reportd.Task.Prompt")
+
+
+def connect(main_loop=False, need_problem=True):
+    """Returns the system bus, the session bus, the Problems2 service, the
+    reportd service and the problems the caller can see, or exits with 77 if
+    there is nothing to talk to.
+    """
+
+    if main_loop:
+        dbus.mainloop.glib.DBusGMainLoop(set_as_default=True)
+
+    try:
+        system_bus = dbus.SystemBus()
+        session_bus = dbus.SessionBus()
+
+        p2 = Problems2Service(system_bus)
+        rd = ReportdService(session_bus)
+
+        problems = p2.GetProblems(0, {})
+    except dbus.exceptions.DBusException as error:
+        print("Skipping, the services cannot be reached: {0}".format(error))
+        sys.exit(77)
+
+    if need_problem and not problems:
+        print("Skipping, there are no problems to work on")
+        sys.exit(77)
+
+    return system_bus, session_bus, p2, rd, problems